@@ -0,0 +1,19 @@
+#ifndef MOCK_AVR_EEPROM_H_
+#define MOCK_AVR_EEPROM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mock.h"
+
+//EEPROM addresses are offsets in mock_eeprom, writes complete right away
+#define EEMEM
+#define eeprom_is_ready() 1
+
+extern uint8_t eeprom_read_byte(const uint8_t *address);
+extern void eeprom_write_byte(uint8_t *address, uint8_t value);
+extern void eeprom_update_byte(uint8_t *address, uint8_t value);
+extern void eeprom_read_block(void *destination, const void *source, size_t size);
+extern void eeprom_update_block(const void *source, void *destination, size_t size);
+
+#endif
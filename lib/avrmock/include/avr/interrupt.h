@@ -0,0 +1,15 @@
+#ifndef MOCK_AVR_INTERRUPT_H_
+#define MOCK_AVR_INTERRUPT_H_
+
+#include "avr/io.h"
+
+//an interrupt handler becomes a function named after its vector, the benchmarks call it
+#define ISR(vector, ...) void vector(void)
+#define ISR_BLOCK
+#define ISR_NOBLOCK
+#define EMPTY_INTERRUPT(vector) void vector(void) {}
+
+#define sei() (SREG |= 0x80)
+#define cli() (SREG &= ~0x80)
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Title:   	AVR register mock, ATmega328P registers and bits
+ *
+ * See mock.h.
+ */
+
+#ifndef MOCK_AVR_IO_H_
+#define MOCK_AVR_IO_H_
+
+#include <stdint.h>
+
+#include "mock.h"
+#include "avr/sfr_defs.h"
+
+#define MOCK_REGISTERS \
+	X(TCCR0A) X(TCCR0B) X(OCR0A) X(OCR0B) X(TIMSK0) X(TIFR0) X(TCNT0) \
+	X(TCCR1A) X(TCCR1B) X(TCCR1C) X(TIMSK1) X(TIFR1) \
+	X(TCCR2A) X(TCCR2B) X(OCR2A) X(OCR2B) X(TIMSK2) X(TIFR2) X(TCNT2) X(ASSR) \
+	X(SPCR) X(PCICR) X(PCMSK0) X(PCMSK1) X(PCMSK2) X(PCIFR) X(EICRA) X(EIMSK) \
+	X(UCSR0A) X(UCSR0B) X(UCSR0C) X(UDR0) X(UBRR0H) X(UBRR0L) \
+	X(PRR) X(MCUSR) X(WDTCSR) X(SMCR) X(ACSR) X(ADCSRA) X(DIDR0) X(DIDR1) \
+	X(SREG) X(EECR) X(EEDR) X(MCUCR)
+
+#define X(reg) extern volatile uint8_t reg;
+MOCK_REGISTERS
+#undef X
+
+extern volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1, UBRR0, EEAR;
+
+//port registers, PINx and DDRx are the two below PORTx as on the target
+#define PINB (mock_ports[MOCK_PORTB].regs[MOCK_PIN])
+#define DDRB (mock_ports[MOCK_PORTB].regs[MOCK_DDR])
+#define PINC (mock_ports[MOCK_PORTC].regs[MOCK_PIN])
+#define DDRC (mock_ports[MOCK_PORTC].regs[MOCK_DDR])
+#define PIND (mock_ports[MOCK_PORTD].regs[MOCK_PIN])
+#define DDRD (mock_ports[MOCK_PORTD].regs[MOCK_DDR])
+
+//counted registers
+#define PORTB (*mock_port(MOCK_PORTB))
+#define PORTC (*mock_port(MOCK_PORTC))
+#define PORTD (*mock_port(MOCK_PORTD))
+#define SPDR (*mock_spdr())
+#define SPSR (*mock_spsr())
+
+enum { PB0, PB1, PB2, PB3, PB4, PB5, PB6, PB7 };
+enum { PC0, PC1, PC2, PC3, PC4, PC5, PC6 };
+enum { PD0, PD1, PD2, PD3, PD4, PD5, PD6, PD7 };
+enum { PCINT16 = 0, PCINT17, PCINT18, PCINT19, PCINT20, PCINT21, PCINT22, PCINT23 };
+enum { PCIE0 = 0, PCIE1, PCIE2 };
+enum { PCIF0 = 0, PCIF1, PCIF2 };
+enum { CS10 = 0, CS11, CS12, WGM12 = 3, WGM13 = 4, ICES1 = 6, ICNC1 = 7 };
+enum { WGM10 = 0, WGM11 = 1, COM1B0 = 4, COM1B1 = 5, COM1A0 = 6, COM1A1 = 7 };
+enum { TOIE1 = 0, OCIE1A = 1, OCIE1B = 2, ICIE1 = 5 };
+enum { TOV1 = 0, OCF1A = 1, OCF1B = 2, ICF1 = 5 };
+enum { TOIE2 = 0, OCIE2A = 1, OCIE2B = 2 };
+enum { TOV2 = 0, OCF2A = 1, OCF2B = 2 };
+enum { WGM20 = 0, WGM21 = 1, COM2B0 = 4, COM2B1 = 5, COM2A0 = 6, COM2A1 = 7 };
+enum { CS20 = 0, CS21 = 1, CS22 = 2, WGM22 = 3 };
+enum { WGM00 = 0, WGM01 = 1, COM0B0 = 4, COM0B1 = 5, COM0A0 = 6, COM0A1 = 7 };
+enum { CS00 = 0, CS01 = 1, CS02 = 2, WGM02 = 3 };
+enum { TOIE0 = 0, OCIE0A = 1, OCIE0B = 2 };
+enum { TOV0 = 0, OCF0A = 1, OCF0B = 2 };
+enum { SPR0 = 0, SPR1, CPHA, CPOL, MSTR, DORD, SPE, SPIE };
+enum { SPI2X = 0, WCOL = 6, SPIF = 7 };
+enum { MPCM0 = 0, U2X0, UPE0, DOR0, FE0, UDRE0, TXC0, RXC0 };
+enum { TXB80 = 0, RXB80, UCSZ02, TXEN0, RXEN0, UDRIE0, TXCIE0, RXCIE0 };
+enum { UCPOL0 = 0, UCSZ00, UCSZ01, USBS0, UPM00, UPM01, UMSEL00, UMSEL01 };
+enum { PRADC = 0, PRUSART0, PRSPI, PRTIM1, PRTIM0 = 5, PRTIM2 = 6, PRTWI = 7 };
+enum { PORF = 0, EXTRF, BORF, WDRF };
+enum { WDP0 = 0, WDP1, WDP2, WDE, WDCE, WDP3, WDIE, WDIF };
+enum { SE = 0, SM0, SM1, SM2 };
+enum { ACIS0 = 0, ACIS1, ACIC, ACIE, ACI, ACO, ACBG, ACD };
+enum { ADPS0 = 0, ADPS1, ADPS2, ADIE, ADIF, ADATE, ADSC, ADEN };
+enum { ADC0D = 0, ADC1D, ADC2D, ADC3D, ADC4D, ADC5D };
+enum { AIN0D = 0, AIN1D };
+enum { EERE = 0, EEPE, EEMPE, EERIE };
+enum { SREG_C = 0, SREG_Z, SREG_N, SREG_V, SREG_S, SREG_H, SREG_T, SREG_I };
+
+#define RAMEND 0x8FF
+#define E2END 0x3FF
+
+#endif
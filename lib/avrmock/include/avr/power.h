@@ -0,0 +1,19 @@
+#ifndef MOCK_AVR_POWER_H_
+#define MOCK_AVR_POWER_H_
+
+#include "avr/io.h"
+
+#define power_adc_disable() (PRR |= _BV(PRADC))
+#define power_adc_enable() (PRR &= ~_BV(PRADC))
+#define power_twi_disable() (PRR |= _BV(PRTWI))
+#define power_twi_enable() (PRR &= ~_BV(PRTWI))
+#define power_spi_disable() (PRR |= _BV(PRSPI))
+#define power_spi_enable() (PRR &= ~_BV(PRSPI))
+#define power_timer0_disable() (PRR |= _BV(PRTIM0))
+#define power_timer0_enable() (PRR &= ~_BV(PRTIM0))
+#define power_timer2_disable() (PRR |= _BV(PRTIM2))
+#define power_timer2_enable() (PRR &= ~_BV(PRTIM2))
+#define power_usart0_disable() (PRR |= _BV(PRUSART0))
+#define power_usart0_enable() (PRR &= ~_BV(PRUSART0))
+
+#endif
@@ -0,0 +1,71 @@
+/**
+ * Title:   	AVR register mock
+ *
+ * Lets the firmware sources build and run on the host, for the benchmarks in test/.
+ * The avr-libc headers in this library declare the registers as plain variables,
+ * except for the ports and the SPI data register: those go through an accessor that
+ * counts pin toggles and shifted bytes. A port value that changed is counted at the
+ * next access of that port, or by mock_sync() before the counters are read.
+ *
+ * The three registers of a port lie in a row as on the target, PINx, DDRx and then
+ * PORTx, so a driver that finds PINx and DDRx below the address of PORTx reads and
+ * writes the right ones.
+ *
+ * mock_lcd() puts the busy flag of an HD44780 on the pins of a display: after every
+ * write, an E pulse with RW low, the flag on DB7 reads busy for the E pulses with RW
+ * high that mock_lcdbusy() sets, or for good with MOCK_LCDSTUCK.
+ *
+ * Delays add to a simulated time instead of waiting, see mock_delayus().
+ */
+
+#ifndef MOCK_H_
+#define MOCK_H_
+
+#include <stdint.h>
+
+//tracked ports
+#define MOCK_PORTB 0
+#define MOCK_PORTC 1
+#define MOCK_PORTD 2
+#define MOCK_PORTS 3
+
+//registers of a port, in the order of the register file
+#define MOCK_PIN 0
+#define MOCK_DDR 1
+#define MOCK_PORT 2
+
+//busy flag reads of mock_lcdbusy() that never end, a display with a broken RW line
+#define MOCK_LCDSTUCK 0xFF
+
+//size of the simulated EEPROM
+#define MOCK_EEPROM_SIZE 1024
+
+typedef struct {
+	volatile uint8_t regs[3];	// PINx, DDRx and PORTx
+	uint8_t seen;				// value at the previous access, toggles since then are not counted yet
+	uint32_t writes;			// accesses, every read-modify-write counts once
+	uint32_t toggles[8];		// level changes per pin
+} mock_port_t;
+
+//the delay functions of the drivers end up here on the host
+#define __builtin_avr_delay_cycles(cycles) mock_delaycycles(cycles)
+
+extern mock_port_t mock_ports[MOCK_PORTS];
+extern uint8_t mock_eeprom[MOCK_EEPROM_SIZE];
+
+//functions
+extern volatile uint8_t *mock_port(uint8_t port);
+extern volatile uint8_t *mock_spdr(void);
+extern volatile uint8_t *mock_spsr(void);
+extern void mock_delaycycles(unsigned long cycles);
+extern void mock_reset(void);
+extern void mock_sync(void);
+extern uint32_t mock_toggles(uint8_t port, uint8_t pin);
+extern uint32_t mock_porttoggles(uint8_t port);
+extern uint32_t mock_spibytes(void);
+extern double mock_delayus(void);
+extern void mock_lcd(uint8_t port_e, uint8_t pin_e, uint8_t port_rw, uint8_t pin_rw, uint8_t port_db7, uint8_t pin_db7);
+extern void mock_lcdbusy(uint8_t reads);
+extern uint32_t mock_lcdreads(void);
+
+#endif
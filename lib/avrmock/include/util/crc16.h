@@ -0,0 +1,23 @@
+#ifndef MOCK_UTIL_CRC16_H_
+#define MOCK_UTIL_CRC16_H_
+
+#include <stdint.h>
+
+//the C equivalents given in the avr-libc documentation
+static inline uint8_t _crc_ibutton_update(uint8_t crc, uint8_t data) {
+	crc = crc ^ data;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 0x01) ? (crc >> 1) ^ 0x8C : crc >> 1;
+	}
+	return crc;
+}
+
+static inline uint16_t _crc16_update(uint16_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+	}
+	return crc;
+}
+
+#endif
@@ -0,0 +1,10 @@
+#ifndef MOCK_UTIL_DELAY_H_
+#define MOCK_UTIL_DELAY_H_
+
+#include "mock.h"
+
+//busy waits add to the simulated time, see mock_delayus()
+extern void _delay_ms(double ms);
+extern void _delay_us(double us);
+
+#endif
@@ -0,0 +1,291 @@
+/**
+ * Title:   	AVR register mock
+ *
+ * See mock.h for what is counted.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "mock.h"
+#include "avr/io.h"
+#include "avr/eeprom.h"
+#include "util/delay.h"
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define X(reg) volatile uint8_t reg;
+MOCK_REGISTERS
+#undef X
+
+volatile uint16_t TCNT1, OCR1A, OCR1B, ICR1, UBRR0, EEAR;
+
+mock_port_t mock_ports[MOCK_PORTS];
+uint8_t mock_eeprom[MOCK_EEPROM_SIZE];
+
+static volatile uint8_t mock_spidata;
+static volatile uint8_t mock_spistatus;
+static uint32_t mock_spiwrites = 0;
+static double mock_delayed = 0;		// microseconds of busy waiting
+
+//busy flag of the display of mock_lcd()
+static uint8_t mock_lcdattached = 0;
+static uint8_t mock_lcdpins[3][2];		// port and pin of E, RW and DB7
+static uint8_t mock_lcdlevel = 0;		// E at the previous port access
+static uint8_t mock_lcdbusyreads = 0;	// reads the flag is busy after a write
+static uint8_t mock_lcdbusyleft = 0;	// reads the flag is still busy
+static uint32_t mock_lcdreadcount = 0;
+
+/**
+ * Function: Counts the pins of a port that changed since its previous access.
+ * Argument: Port.
+ * Returns: None.
+ */
+static void mock_count(mock_port_t *port) {
+	uint8_t changed = port->regs[MOCK_PORT] ^ port->seen;
+
+	for (uint8_t pin = 0; pin < 8; pin++) {
+		if (changed & (1 << pin)) {
+			port->toggles[pin]++;
+		}
+	}
+	port->seen = port->regs[MOCK_PORT];
+}
+
+/**
+ * Function: Level of a pin of mock_lcd() as the ports drive it.
+ * Argument: 0 for E, 1 for RW.
+ * Returns: 1 high, 0 low.
+ */
+static uint8_t mock_lcdpin(uint8_t line) {
+	return (mock_ports[mock_lcdpins[line][0]].regs[MOCK_PORT] >> mock_lcdpins[line][1]) & 0x01;
+}
+
+/**
+ * Function: Follows the E pulses of the display of mock_lcd() and puts its busy flag on DB7.
+ * A pulse ends at the falling edge of E, which is seen at the port access after it.
+ * Argument: None.
+ * Returns: None.
+ */
+static void mock_lcdstep(void) {
+	uint8_t e = mock_lcdpin(0);
+	uint8_t rw = mock_lcdpin(1);
+	volatile uint8_t *pin = &mock_ports[mock_lcdpins[2][0]].regs[MOCK_PIN];
+
+	if (mock_lcdlevel && !e) {
+		if (!rw) {
+			mock_lcdbusyleft = mock_lcdbusyreads;  // The display takes a while for a write
+		}
+		else {
+			mock_lcdreadcount++;
+			if (mock_lcdbusyleft > 0 && mock_lcdbusyleft != MOCK_LCDSTUCK) {
+				mock_lcdbusyleft--;
+			}
+		}
+	}
+	mock_lcdlevel = e;
+
+	if (rw && mock_lcdbusyleft > 0) {
+		*pin |= (1 << mock_lcdpins[2][1]);
+	}
+	else {
+		*pin &= ~(1 << mock_lcdpins[2][1]);
+	}
+}
+
+/**
+ * Function: Accessor behind PORTB, PORTC and PORTD.
+ * Argument: MOCK_PORTB, MOCK_PORTC or MOCK_PORTD.
+ * Returns: The register, to be read or written by the caller.
+ */
+volatile uint8_t *mock_port(uint8_t port) {
+	if (mock_lcdattached) {
+		mock_lcdstep();
+	}
+	mock_count(&mock_ports[port]);
+	mock_ports[port].writes++;
+	return &mock_ports[port].regs[MOCK_PORT];
+}
+
+/**
+ * Function: Accessor behind SPDR, every access is a byte shifted out.
+ * Argument: None.
+ * Returns: The register.
+ */
+volatile uint8_t *mock_spdr(void) {
+	mock_spiwrites++;
+	return &mock_spidata;
+}
+
+/**
+ * Function: Accessor behind SPSR, a transfer is always complete.
+ * Argument: None.
+ * Returns: The register.
+ */
+volatile uint8_t *mock_spsr(void) {
+	mock_spistatus |= (1 << SPIF);
+	return &mock_spistatus;
+}
+
+/**
+ * Function: Adds a cycle delay of the drivers to the simulated time.
+ * Argument: Cycles at F_CPU.
+ * Returns: None.
+ */
+void mock_delaycycles(unsigned long cycles) {
+	mock_delayed += cycles * 1000000.0 / F_CPU;
+}
+
+/**
+ * Function: Adds a millisecond delay to the simulated time.
+ * Argument: Milliseconds.
+ * Returns: None.
+ */
+void _delay_ms(double ms) {
+	mock_delayed += ms * 1000;
+}
+
+/**
+ * Function: Adds a microsecond delay to the simulated time.
+ * Argument: Microseconds.
+ * Returns: None.
+ */
+void _delay_us(double us) {
+	mock_delayed += us;
+}
+
+/**
+ * Function: Clears the counters and the simulated delay time, the register values are kept.
+ * Argument: None.
+ * Returns: None.
+ */
+void mock_reset(void) {
+	for (uint8_t i = 0; i < MOCK_PORTS; i++) {
+		mock_ports[i].seen = mock_ports[i].regs[MOCK_PORT];
+		mock_ports[i].writes = 0;
+		memset(mock_ports[i].toggles, 0, sizeof(mock_ports[i].toggles));
+	}
+	mock_spiwrites = 0;
+	mock_delayed = 0;
+	mock_lcdreadcount = 0;
+}
+
+/**
+ * Function: Counts the last changes of every port, call before reading the counters.
+ * Argument: None.
+ * Returns: None.
+ */
+void mock_sync(void) {
+	for (uint8_t i = 0; i < MOCK_PORTS; i++) {
+		mock_count(&mock_ports[i]);
+	}
+}
+
+/**
+ * Function: Level changes of a pin since mock_reset(), call mock_sync() first.
+ * Argument: Port and pin.
+ * Returns: Toggles.
+ */
+uint32_t mock_toggles(uint8_t port, uint8_t pin) {
+	return mock_ports[port].toggles[pin];
+}
+
+/**
+ * Function: Level changes of all pins of a port since mock_reset(), call mock_sync() first.
+ * Argument: Port.
+ * Returns: Toggles.
+ */
+uint32_t mock_porttoggles(uint8_t port) {
+	uint32_t total = 0;
+
+	for (uint8_t pin = 0; pin < 8; pin++) {
+		total += mock_ports[port].toggles[pin];
+	}
+	return total;
+}
+
+/**
+ * Function: Bytes written to SPDR since mock_reset().
+ * Argument: None.
+ * Returns: Bytes.
+ */
+uint32_t mock_spibytes(void) {
+	return mock_spiwrites;
+}
+
+/**
+ * Function: Time spent in delays since mock_reset().
+ * Argument: None.
+ * Returns: Microseconds.
+ */
+double mock_delayus(void) {
+	return mock_delayed;
+}
+
+/**
+ * Function: Puts the busy flag of an HD44780 on the pins of a display, not busy until mock_lcdbusy().
+ * Arguments:
+ * 		1. Port and pin of E.
+ * 		2. Port and pin of RW.
+ * 		3. Port and pin of DB7, the flag is on its PINx bit.
+ * Returns: None.
+ */
+void mock_lcd(uint8_t port_e, uint8_t pin_e, uint8_t port_rw, uint8_t pin_rw, uint8_t port_db7, uint8_t pin_db7) {
+	const uint8_t pins[3][2] = {{port_e, pin_e}, {port_rw, pin_rw}, {port_db7, pin_db7}};
+
+	memcpy(mock_lcdpins, pins, sizeof(mock_lcdpins));
+	mock_lcdlevel = mock_lcdpin(0);
+	mock_lcdbusyreads = 0;
+	mock_lcdbusyleft = 0;
+	mock_lcdattached = 1;
+}
+
+/**
+ * Function: Sets how long the display of mock_lcd() is busy, from now and after every write.
+ * Argument: E pulses with RW high the flag reads busy, two per read in 4 bit mode, MOCK_LCDSTUCK for ever.
+ * Returns: None.
+ */
+void mock_lcdbusy(uint8_t reads) {
+	mock_lcdbusyreads = reads;
+	mock_lcdbusyleft = reads;
+}
+
+/**
+ * Function: E pulses with RW high to the display of mock_lcd() since mock_reset().
+ * Argument: None.
+ * Returns: Pulses.
+ */
+uint32_t mock_lcdreads(void) {
+	return mock_lcdreadcount;
+}
+
+/**
+ * Function: The avr-libc EEPROM functions, on mock_eeprom.
+ * Argument: As avr-libc.
+ * Returns: As avr-libc.
+ */
+uint8_t eeprom_read_byte(const uint8_t *address) {
+	return mock_eeprom[(uintptr_t)address % MOCK_EEPROM_SIZE];
+}
+
+void eeprom_write_byte(uint8_t *address, uint8_t value) {
+	mock_eeprom[(uintptr_t)address % MOCK_EEPROM_SIZE] = value;
+}
+
+void eeprom_update_byte(uint8_t *address, uint8_t value) {
+	eeprom_write_byte(address, value);
+}
+
+void eeprom_read_block(void *destination, const void *source, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		((uint8_t *)destination)[i] = eeprom_read_byte((const uint8_t *)source + i);
+	}
+}
+
+void eeprom_update_block(const void *source, void *destination, size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		eeprom_update_byte((uint8_t *)destination + i, ((const uint8_t *)source)[i]);
+	}
+}
@@ -0,0 +1,10 @@
+# Address and undefined behaviour sanitizers for the host benchmarks
+#
+# build_flags only reach the compiler, the sanitizer runtime has to be linked as well.
+# A stray access to a mocked register then stops the run with its stack trace.
+
+Import("env")
+
+SANITIZE = ["-fsanitize=address,undefined", "-fno-omit-frame-pointer", "-fno-sanitize-recover=all"]
+
+env.Append(CCFLAGS=SANITIZE, LINKFLAGS=SANITIZE)
@@ -0,0 +1,30 @@
+# RAM report after every firmware build
+#
+# Prints the bytes of .data, .bss and .noinit from avr-size and what is left for the
+# stack. Compare the stack part with the high-water mark the firmware measures at
+# run time, GET MEMORY over the UART, see src/stack.h.
+
+import subprocess
+
+Import("env")
+
+RAM_SECTIONS = (".data", ".bss", ".noinit")
+
+
+def size_report(source, target, env):
+    output = subprocess.check_output([env.subst("$SIZETOOL"), "-A", str(source[0])]).decode()
+    sizes = dict.fromkeys(RAM_SECTIONS, 0)
+
+    for line in output.splitlines():
+        fields = line.split()
+        if len(fields) >= 2 and fields[0] in sizes:
+            sizes[fields[0]] = int(fields[1])
+
+    ram = int(env.BoardConfig().get("upload.maximum_ram_size", 2048))
+    taken = sum(sizes.values())
+
+    print("RAM report: " + ", ".join("%s %d" % (name, sizes[name]) for name in RAM_SECTIONS)
+          + " bytes, %d of %d bytes left for the stack" % (ram - taken, ram))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report)
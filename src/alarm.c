@@ -0,0 +1,116 @@
+/**
+ * Title:   	Debounced limit alarm
+ *
+ * See alarm.h for how readings confirm and end an alarm.
+ */
+
+#include <stdint.h>
+
+#include "alarm.h"
+
+static int16_t alarm_hysteresis = 0;
+static uint8_t alarm_confirm = 1;		// readings out of the last alarm_window that change the state
+static uint8_t alarm_mask = 0x01;		// bits of the last alarm_window readings
+static uint16_t alarm_dwell = 0;		// least time in milliseconds a state is held
+
+/**
+ * Function: Counts the readings of the window in a result mask.
+ * Argument: Result mask.
+ * Returns: Number of bits set within the window.
+ */
+static uint8_t alarm_count(uint8_t results) {
+	uint8_t count = 0;
+
+	results &= alarm_mask;
+	while (results) {
+		results &= results - 1;  // Clears the lowest bit that is set
+		count++;
+	}
+	return count;
+}
+
+/**
+ * Function: Sets how readings change the alarm state, for all alarms.
+ * Arguments:
+ * 		1. Distance a reading has to get back within a limit to count as within, in the unit of the readings.
+ * 		2. Readings out of the window that have to agree before the state changes, at least 1.
+ * 		3. Readings the window holds, confirm up to ALARM_WINDOW_MAX.
+ * 		4. Least time in milliseconds a state is held.
+ * Returns: None.
+ */
+void alarm_configure(int16_t hysteresis, uint8_t confirm, uint8_t window, uint16_t dwell_ms) {
+	if (window > ALARM_WINDOW_MAX) {
+		window = ALARM_WINDOW_MAX;
+	}
+	if (confirm < 1) {
+		confirm = 1;
+	}
+	if (window < confirm) {
+		window = confirm;
+	}
+
+	alarm_hysteresis = (hysteresis < 0) ? 0 : hysteresis;
+	alarm_confirm = confirm;
+	alarm_mask = (uint8_t)((1U << window) - 1);
+	alarm_dwell = dwell_ms;
+}
+
+/**
+ * Function: Puts an alarm in its initial state: off, with no readings.
+ * Argument: Alarm.
+ * Returns: None.
+ */
+void alarm_reset(alarm_t *alarm) {
+	alarm->state = ALARM_NONE;
+	alarm->high = 0;
+	alarm->low = 0;
+	alarm->inside = 0;
+	alarm->changed = 0;
+	alarm->since = 0;
+}
+
+/**
+ * Function: Adds a reading to an alarm and updates its state.
+ * Arguments:
+ * 		1. Alarm.
+ * 		2. Reading.
+ * 		3. Lower limit, ALARM_NOLIMIT for none.
+ * 		4. Upper limit, ALARM_NOLIMIT for none.
+ * 		5. Current time in milliseconds.
+ * Returns: New state, ALARM_HIGH, ALARM_LOW or ALARM_NONE.
+ */
+int8_t alarm_update(alarm_t *alarm, int16_t value, int16_t limit_min, int16_t limit_max, uint32_t now) {
+	uint8_t high = 0;
+	uint8_t low = 0;
+	int8_t target = alarm->state;
+
+	// A reading in the hysteresis band keeps counting for the alarm that is on
+	if (limit_max != ALARM_NOLIMIT) {
+		high = value > limit_max || (alarm->state == ALARM_HIGH && value > limit_max - alarm_hysteresis);
+	}
+	if (limit_min != ALARM_NOLIMIT) {
+		low = value < limit_min || (alarm->state == ALARM_LOW && value < limit_min + alarm_hysteresis);
+	}
+
+	alarm->high = (alarm->high << 1) | high;
+	alarm->low = (alarm->low << 1) | low;
+	alarm->inside = (alarm->inside << 1) | (!high && !low);
+
+	if (alarm_count(alarm->high) >= alarm_confirm) {
+		target = ALARM_HIGH;
+	}
+	else if (alarm_count(alarm->low) >= alarm_confirm) {
+		target = ALARM_LOW;
+	}
+	else if (alarm_count(alarm->inside) >= alarm_confirm) {
+		target = ALARM_NONE;
+	}
+
+	// The initial state was never entered, so the first change doesn't wait for the dwell
+	if (target != alarm->state && (!alarm->changed || now - alarm->since >= alarm_dwell)) {
+		alarm->state = target;
+		alarm->changed = 1;
+		alarm->since = now;
+	}
+	return alarm->state;
+}
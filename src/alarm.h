@@ -0,0 +1,44 @@
+/**
+ * Title:   	Debounced limit alarm
+ *
+ * Turns readings into a stable alarm state: ALARM_HIGH, ALARM_LOW or ALARM_NONE.
+ * Every reading is compared with the limits, and the last ALARM_WINDOW_MAX results
+ * are kept as bit masks. A state is entered once the reading was outside the same
+ * limit in at least `confirm` of the last `window` readings, and it is left once it
+ * was back within `confirm` of them. While an alarm is on, a reading only counts as
+ * back within once it is past the limit by the hysteresis. A state that was entered
+ * is held for at least the dwell time, so a reading hovering at a limit can't make
+ * the alarm flap.
+ */
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+#include <stdint.h>
+
+//limit value meaning no limit
+#define ALARM_NOLIMIT (-32767 - 1)
+
+//states, the direction in which a limit is exceeded
+#define ALARM_NONE 0
+#define ALARM_HIGH 1
+#define ALARM_LOW -1
+
+//largest window, the results are kept in the bits of a byte
+#define ALARM_WINDOW_MAX 8
+
+typedef struct {
+	int8_t state;			// ALARM_NONE, ALARM_HIGH or ALARM_LOW
+	uint8_t high;			// readings above the upper limit, newest in bit 0
+	uint8_t low;			// readings below the lower limit
+	uint8_t inside;			// readings within both limits
+	uint8_t changed;		// 1 once the state has changed, the dwell only holds a state that was entered
+	uint32_t since;			// millis the state last changed
+} alarm_t;
+
+//functions
+extern void alarm_configure(int16_t hysteresis, uint8_t confirm, uint8_t window, uint16_t dwell_ms);
+extern void alarm_reset(alarm_t *alarm);
+extern int8_t alarm_update(alarm_t *alarm, int16_t value, int16_t limit_min, int16_t limit_max, uint32_t now);
+
+#endif
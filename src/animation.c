@@ -0,0 +1,156 @@
+/**
+ * Title:   	LED matrix animation engine
+ *
+ * See animation.h for an explanation of sprites and steps.
+ */
+
+#include <avr/pgmspace.h>
+
+#include "animation.h"
+#include "max7219/max7219.h"
+
+static const animation_step_t *animation_first = 0;  // first step of the animation, in flash
+static const animation_step_t *animation_step = 0;  // current step, in flash
+static uint8_t animation_type = ANIMATION_END;  // type of the current step
+static uint8_t animation_frames = 0;  // frames of the current step
+static const uint8_t *animation_sprite = 0;  // sprite of the current step, in flash
+static uint8_t animation_frame = 0;  // frame within the current step
+static uint8_t animation_repetitions = 0;  // repetitions left after the current one
+
+/**
+ * Function: Loads the step the step pointer points at.
+ * Argument: None.
+ * Returns: None.
+ */
+static void animation_load(void) {
+	animation_type = pgm_read_byte(&animation_step->type);
+	animation_frames = pgm_read_byte(&animation_step->frames);
+	animation_sprite = (const uint8_t *)pgm_read_ptr(&animation_step->sprite);
+	animation_frame = 0;
+
+	switch (animation_type) {
+		case ANIMATION_SLIDE_IN:
+		case ANIMATION_SLIDE_OUT:
+		case ANIMATION_WIPE_IN:
+		case ANIMATION_WIPE_OUT:
+			animation_frames = 8;
+			break;
+		case ANIMATION_FADE_IN:
+		case ANIMATION_FADE_OUT:
+			animation_frames = 16;
+			break;
+	}
+	if (animation_frames == 0) {
+		animation_frames = 1;
+	}
+}
+
+/**
+ * Function: Starts an animation, replacing the one that is running.
+ * Arguments:
+ * 		1. List of steps in flash, ended by an ANIMATION_END step.
+ * 		2. Amount of repetitions, at least 1.
+ * Returns: None.
+ */
+void animation_play(const animation_step_t *animation, uint8_t repetitions) {
+	animation_first = animation;
+	animation_step = animation;
+	animation_repetitions = repetitions > 0 ? repetitions - 1 : 0;
+	animation_load();
+
+	if (animation_type == ANIMATION_END || repetitions == 0) {
+		animation_stop();
+	}
+}
+
+/**
+ * Function: Stops the running animation, the matrix keeps the last frame.
+ * Argument: None.
+ * Returns: None.
+ */
+void animation_stop(void) {
+	animation_type = ANIMATION_END;
+	max7219_intensity(ANIMATION_ICNUM, ANIMATION_INTENSITY);
+}
+
+/**
+ * Function: Checks if the animation has finished.
+ * Argument: None.
+ * Returns: 1 when no animation is running, otherwise 0.
+ */
+uint8_t animation_done(void) {
+	return animation_type == ANIMATION_END;
+}
+
+/**
+ * Function: Draws the next frame of the running animation.
+ * Argument: None.
+ * Returns: None.
+ */
+void animation_tick(void) {
+	uint8_t *frame = max7219_framebuffer(ANIMATION_ICNUM);
+	uint8_t f = animation_frame;
+
+	if (animation_type == ANIMATION_END) {
+		return;
+	}
+
+	for(uint8_t row = 0; row < 8; row++) {
+		uint8_t sprite = pgm_read_byte(&animation_sprite[row]);
+
+		switch (animation_type) {
+			case ANIMATION_SLIDE_IN:
+				frame[row] = sprite >> (7 - f);
+				break;
+			case ANIMATION_SLIDE_OUT:
+				frame[row] = (f < 7) ? sprite << (f + 1) : 0;
+				break;
+			case ANIMATION_WIPE_IN:
+				frame[row] = (row <= f) ? sprite : 0;
+				break;
+			case ANIMATION_WIPE_OUT:
+				frame[row] = (row <= f) ? 0 : sprite;
+				break;
+			case ANIMATION_BLINK:
+				frame[row] = (f & 0x01) ? 0 : sprite;
+				break;
+			default:  // Keyframe and fades show the sprite as is
+				frame[row] = sprite;
+				break;
+		}
+	}
+
+	if (animation_type == ANIMATION_FADE_IN) {
+		max7219_intensity(ANIMATION_ICNUM, f);
+	}
+	else if (animation_type == ANIMATION_FADE_OUT) {
+		max7219_intensity(ANIMATION_ICNUM, 15 - f);
+	}
+
+	max7219_flush();  // Only rows that changed are sent
+
+	// Move on to the next frame, step or repetition
+	if (++animation_frame < animation_frames) {
+		return;
+	}
+	if (animation_type == ANIMATION_FADE_OUT) {  // Leave the matrix blank at full intensity
+		for(uint8_t row = 0; row < 8; row++) {
+			frame[row] = 0;
+		}
+		max7219_flush();
+		max7219_intensity(ANIMATION_ICNUM, ANIMATION_INTENSITY);
+	}
+
+	animation_step++;
+	animation_load();
+
+	if (animation_type == ANIMATION_END) {
+		if (animation_repetitions == 0) {
+			animation_stop();
+			return;
+		}
+		animation_repetitions--;
+		animation_step = animation_first;
+		animation_load();
+	}
+}
@@ -0,0 +1,42 @@
+/**
+ * Title:   	LED matrix animation engine
+ *
+ * Sprites (8 rows of 8 bits) and animations live in flash. An animation is a list of steps,
+ * each step shows a sprite with a transition or as a keyframe. animation_tick() draws one
+ * frame in the max7219 frame buffer and flushes it, call it once per frame from a scheduler task.
+ */
+
+#ifndef ANIMATION_H_
+#define ANIMATION_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+//led matrix the animations are drawn on
+#define ANIMATION_ICNUM 0
+#define ANIMATION_INTENSITY 15 //intensity after a fade
+
+//step types
+#define ANIMATION_END 0 //last step of an animation
+#define ANIMATION_KEYFRAME 1 //show the sprite for a number of frames
+#define ANIMATION_SLIDE_IN 2 //slide in from the right, 8 frames
+#define ANIMATION_SLIDE_OUT 3 //slide out to the left, 8 frames
+#define ANIMATION_WIPE_IN 4 //show row after row from the top, 8 frames
+#define ANIMATION_WIPE_OUT 5 //clear row after row from the top, 8 frames
+#define ANIMATION_BLINK 6 //toggle the sprite on and off, for a number of frames
+#define ANIMATION_FADE_IN 7 //ramp the intensity up, 16 frames
+#define ANIMATION_FADE_OUT 8 //ramp the intensity down, 16 frames
+
+typedef struct {
+	uint8_t type;
+	uint8_t frames; //only used by keyframe and blink
+	const uint8_t *sprite; //8 rows in flash
+} animation_step_t;
+
+//functions
+extern void animation_play(const animation_step_t *animation, uint8_t repetitions);
+extern void animation_stop(void);
+extern uint8_t animation_done(void);
+extern void animation_tick(void);
+
+#endif
@@ -0,0 +1,232 @@
+/**
+ * Title:   	Serial command interface
+ *
+ * See command.h for the command syntax.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
+
+#include "command.h"
+#include "config.h"
+#include "format.h"
+#include "uart.h"
+#include "power.h"
+#include "stack.h"
+
+//longest reply, a setting name with its value
+#define COMMAND_REPLYSIZE 24
+
+// Setting names, in the order of the CONFIG_ keys
+static const char command_names[CONFIG_KEYS][10] PROGMEM = {
+	"TMIN", "TMAX", "HMIN", "HMAX", "HYST", "SAMPLE", "DISPLAY", "TELEMETRY", "CONFIRM", "WINDOW", "DWELL"
+};
+
+static char command_line[COMMAND_LINESIZE];
+static uint8_t command_length = 0;
+static uint8_t command_overflow = 0;  // the line got too long, ignored up to its end
+
+/**
+ * Function: Sends a reply line. A reply that does not fit in the transmit ring is dropped.
+ * Arguments:
+ * 		1. Text, not terminated.
+ * 		2. Length of the text.
+ * Returns: None.
+ */
+static void command_reply(char *reply, uint8_t length) {
+	reply[length++] = '\r';
+	reply[length++] = '\n';
+	uart_write((const uint8_t *)reply, length);
+}
+
+/**
+ * Function: Sends a reply from flash.
+ * Argument: Text in flash.
+ * Returns: None.
+ */
+static void command_reply_P(const char *text) {
+	char reply[COMMAND_REPLYSIZE];
+
+	strcpy_P(reply, text);
+	command_reply(reply, strlen(reply));
+}
+
+/**
+ * Function: Looks up a setting name.
+ * Argument: Name.
+ * Returns: CONFIG_ key, or CONFIG_KEYS when the name is unknown.
+ */
+static uint8_t command_key(const char *name) {
+	uint8_t key;
+
+	for (key = 0; key < CONFIG_KEYS; key++) {
+		if (name && strcmp_P(name, command_names[key]) == 0) {
+			break;
+		}
+	}
+	return key;
+}
+
+/**
+ * Function: Replies with the value of a setting.
+ * Argument: CONFIG_ key.
+ * Returns: None.
+ */
+static void command_get(uint8_t key) {
+	char reply[COMMAND_REPLYSIZE];
+	uint8_t length;
+	int32_t value = config_get(key);
+
+	strcpy_P(reply, command_names[key]);
+	length = strlen(reply);
+	reply[length++] = '=';
+	if (key <= CONFIG_HUM_MAX && value == CONFIG_NOLIMIT) {
+		strcpy_P(reply + length, PSTR("OFF"));
+		length += 3;
+	}
+	else {
+		length += format_number(reply + length, value, config_decimals(key));
+	}
+	command_reply(reply, length);
+}
+
+/**
+ * Function: Replies with the measured sleep time and the average current with the displays on and blanked.
+ * Argument: None.
+ * Returns: None.
+ */
+static void command_power(void) {
+	char reply[COMMAND_REPLYSIZE + 8];
+	uint8_t length;
+
+	strcpy_P(reply, PSTR("POWER="));
+	length = 6;
+	length += format_number(reply + length, power_sleepratio(), 1);  // Per mille as a percentage
+	reply[length++] = '%';
+	reply[length++] = ' ';
+	length += format_number(reply + length, power_current(POWER_DISPLAYS_ON), 0);
+	strcpy_P(reply + length, PSTR("uA/"));
+	length += 3;
+	length += format_number(reply + length, power_current(POWER_DISPLAYS_BLANKED), 0);
+	strcpy_P(reply + length, PSTR("uA"));
+	length += 2;
+	command_reply(reply, length);
+}
+
+/**
+ * Function: Replies with the RAM taken by the variables, the stack high-water mark and the RAM the stack never reached.
+ * Argument: None.
+ * Returns: None.
+ */
+static void command_memory(void) {
+	char reply[COMMAND_REPLYSIZE + 8];
+	uint8_t length;
+
+	strcpy_P(reply, PSTR("MEMORY="));
+	length = 7;
+	length += format_number(reply + length, stack_static(), 0);
+	reply[length++] = '+';
+	length += format_number(reply + length, stack_peak(), 0);
+	reply[length++] = 'B';
+	reply[length++] = ' ';
+	length += format_number(reply + length, stack_unused(), 0);
+	strcpy_P(reply + length, PSTR("B free"));
+	length += 6;
+	command_reply(reply, length);
+}
+
+/**
+ * Function: Changes a setting and replies with the result.
+ * Arguments:
+ * 		1. CONFIG_ key.
+ * 		2. Value as text.
+ * Returns: None.
+ */
+static void command_set(uint8_t key, const char *text) {
+	int32_t value;
+
+	if (key <= CONFIG_HUM_MAX && strcmp_P(text, PSTR("OFF")) == 0) {
+		value = CONFIG_NOLIMIT;
+	}
+	else if (format_parse(text, config_decimals(key), &value) != 0) {
+		command_reply_P(PSTR("ERR VALUE"));
+		return;
+	}
+
+	switch (config_set(key, value)) {
+		case CONFIG_OK: command_reply_P(PSTR("OK")); break;
+		case CONFIG_ERR_ORDER: command_reply_P(PSTR("ERR MIN > MAX")); break;
+		default: command_reply_P(PSTR("ERR RANGE")); break;
+	}
+}
+
+/**
+ * Function: Executes a complete command line.
+ * Argument: Terminated line, in upper case.
+ * Returns: None.
+ */
+static void command_execute(char *line) {
+	char *verb = strtok(line, " ");
+	char *name = strtok(NULL, " ");
+	char *value = strtok(NULL, " ");
+	uint8_t key = command_key(name);
+
+	if (verb == NULL) {
+		return;  // Empty line
+	}
+	power_activity();  // Someone is at the unit, show the displays
+
+	if (key == CONFIG_KEYS && name && strcmp_P(name, PSTR("POWER")) == 0 && strcmp_P(verb, PSTR("GET")) == 0 && value == NULL) {
+		command_power();
+	}
+	else if (key == CONFIG_KEYS && name && strcmp_P(name, PSTR("MEMORY")) == 0 && strcmp_P(verb, PSTR("GET")) == 0 && value == NULL) {
+		command_memory();
+	}
+	else if (key == CONFIG_KEYS) {
+		command_reply_P(PSTR("ERR SETTING"));
+	}
+	else if (strcmp_P(verb, PSTR("GET")) == 0 && value == NULL) {
+		command_get(key);
+	}
+	else if (strcmp_P(verb, PSTR("SET")) == 0 && value != NULL && strtok(NULL, " ") == NULL) {
+		command_set(key, value);
+	}
+	else {
+		command_reply_P(PSTR("ERR SYNTAX"));
+	}
+}
+
+/**
+ * Task: Collects received characters and executes the line once it is complete.
+ * Runs every COMMAND_POLL_MS milliseconds.
+ */
+void command_task(void) {
+	int16_t c;
+
+	while ((c = uart_getc()) >= 0) {
+		if (c == '\r' || c == '\n') {
+			uint8_t overflow = command_overflow;
+			uint8_t length = command_length;
+
+			command_line[command_length] = 0;
+			command_length = 0;
+			command_overflow = 0;
+
+			if (overflow) {
+				command_reply_P(PSTR("ERR LENGTH"));
+				return;
+			}
+			if (length > 0) {
+				command_execute(command_line);
+				return;  // One line per run, the rest waits in the receive ring
+			}
+		}
+		else if (command_length < COMMAND_LINESIZE - 1) {
+			command_line[command_length++] = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+		}
+		else {
+			command_overflow = 1;
+		}
+	}
+}
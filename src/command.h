@@ -0,0 +1,34 @@
+/**
+ * Title:   	Serial command interface
+ *
+ * Reads text commands from the UART receive ring, one line at a time:
+ * 		GET <setting>				replies <setting>=<value>
+ * 		SET <setting> <value>		replies OK or ERR <reason>
+ * Settings are TMIN, TMAX, HMIN, HMAX, HYST, SAMPLE, DISPLAY, TELEMETRY, CONFIRM, WINDOW
+ * and DWELL. Limits and hysteresis take decimals like the readings, e.g. SET TMAX 28.5
+ * on a DHT22, and OFF removes a limit. SAMPLE, DISPLAY and DWELL are in milliseconds,
+ * TELEMETRY is 0 (off), 1 (binary) or 2 (CSV). An alarm changes once CONFIRM out of the
+ * last WINDOW readings agree, see alarm.h. GET POWER replies the share of time asleep
+ * and the estimated average current with the displays on and blanked, see power.h.
+ * GET MEMORY replies the bytes of the variables plus the stack high-water mark, and the
+ * RAM the stack never reached, see stack.h.
+ * Commands are not case sensitive and end with CR, LF or both.
+ *
+ * command_task() handles at most one line per run and never waits for input.
+ */
+
+#ifndef COMMAND_H_
+#define COMMAND_H_
+
+#include <stdint.h>
+
+//time between two runs of command_task(), the receive ring holds 8 ms of input at 38400 baud
+#define COMMAND_POLL_MS 5
+
+//longest command line, longer lines are refused
+#define COMMAND_LINESIZE 24
+
+//functions
+extern void command_task(void);
+
+#endif
@@ -0,0 +1,171 @@
+/**
+ * Title:   	Run-time configuration
+ *
+ * See config.h.
+ */
+
+#include <stdint.h>
+
+#include "config.h"
+#include "persist.h"
+#include "dht.h"
+#include "telemetry.h"
+
+//allowed ranges, in the unit of the readings for the limits
+#define CONFIG_TEMP_LOWEST (-40 * DHT_SCALE)
+#define CONFIG_TEMP_HIGHEST (80 * DHT_SCALE)
+#define CONFIG_HUM_LOWEST 0
+#define CONFIG_HUM_HIGHEST (100 * DHT_SCALE)
+#define CONFIG_HYSTERESIS_HIGHEST (10 * DHT_SCALE)
+#define CONFIG_SAMPLE_LOWEST DHT_SAMPLEMS
+#define CONFIG_DISPLAY_LOWEST 500
+#define CONFIG_MS_HIGHEST 60000
+
+//the configuration and its CRC have to fit in the EEPROM block
+typedef char config_size_check[(sizeof(config_t) < PERSIST_CONFIG_SIZE) ? 1 : -1];
+
+config_t config;
+
+static void (*config_callback)(uint8_t key) = 0;
+
+/**
+ * Function: Checks a limit against its range.
+ * Arguments:
+ * 		1. Limit.
+ * 		2. Lowest allowed value.
+ * 		3. Highest allowed value.
+ * Returns: 1 when it is in range or CONFIG_NOLIMIT, 0 otherwise.
+ */
+static uint8_t config_limitvalid(int16_t limit, int16_t lowest, int16_t highest) {
+	return limit == CONFIG_NOLIMIT || (limit >= lowest && limit <= highest);
+}
+
+/**
+ * Function: Checks a complete configuration.
+ * Argument: Configuration.
+ * Returns: CONFIG_OK, CONFIG_ERR_RANGE for a value out of range, CONFIG_ERR_ORDER for a minimum above its maximum.
+ */
+static int8_t config_check(const config_t *candidate) {
+	if (!config_limitvalid(candidate->temp_min, CONFIG_TEMP_LOWEST, CONFIG_TEMP_HIGHEST)
+		|| !config_limitvalid(candidate->temp_max, CONFIG_TEMP_LOWEST, CONFIG_TEMP_HIGHEST)
+		|| !config_limitvalid(candidate->hum_min, CONFIG_HUM_LOWEST, CONFIG_HUM_HIGHEST)
+		|| !config_limitvalid(candidate->hum_max, CONFIG_HUM_LOWEST, CONFIG_HUM_HIGHEST)
+		|| candidate->hysteresis < 0 || candidate->hysteresis > CONFIG_HYSTERESIS_HIGHEST
+		|| candidate->sample_ms < CONFIG_SAMPLE_LOWEST || candidate->sample_ms > CONFIG_MS_HIGHEST
+		|| candidate->display_ms < CONFIG_DISPLAY_LOWEST || candidate->display_ms > CONFIG_MS_HIGHEST
+		|| candidate->telemetry > TELEMETRY_CSV
+		|| candidate->window < 1 || candidate->window > ALARM_WINDOW_MAX
+		|| candidate->confirm < 1 || candidate->confirm > candidate->window
+		|| candidate->dwell_ms > CONFIG_MS_HIGHEST) {
+		return CONFIG_ERR_RANGE;
+	}
+
+	// Normally the lower limit can't be over the upper limit
+	if ((candidate->temp_min != CONFIG_NOLIMIT && candidate->temp_max != CONFIG_NOLIMIT && candidate->temp_min > candidate->temp_max)
+		|| (candidate->hum_min != CONFIG_NOLIMIT && candidate->hum_max != CONFIG_NOLIMIT && candidate->hum_min > candidate->hum_max)) {
+		return CONFIG_ERR_ORDER;
+	}
+
+	return CONFIG_OK;
+}
+
+/**
+ * Function: Loads the saved configuration, or the defaults when none is saved or it is not valid.
+ * Argument: Default configuration.
+ * Returns: None.
+ */
+void config_init(const config_t *defaults) {
+	if (persist_loadconfig(&config, sizeof(config)) != 0 || config_check(&config) != CONFIG_OK) {
+		config = *defaults;
+	}
+}
+
+/**
+ * Function: Changes a setting when the result is a valid configuration, and saves it.
+ * Arguments:
+ * 		1. Setting, CONFIG_TEMP_MIN up to CONFIG_DWELL_MS.
+ * 		2. New value, limits in the unit of the readings.
+ * Returns: CONFIG_OK, or the CONFIG_ERR_ code telling why the value was refused.
+ */
+int8_t config_set(uint8_t key, int32_t value) {
+	config_t candidate = config;
+
+	if (key >= CONFIG_KEYS) {
+		return CONFIG_ERR_KEY;
+	}
+	if (value < -32768 || value > 65535) {  // Does not fit any field, the check below sorts out the rest
+		return CONFIG_ERR_RANGE;
+	}
+	if (key <= CONFIG_HYSTERESIS && value > 32767) {
+		return CONFIG_ERR_RANGE;
+	}
+	if (key > CONFIG_HYSTERESIS && value < 0) {
+		return CONFIG_ERR_RANGE;
+	}
+
+	switch (key) {
+		case CONFIG_TEMP_MIN: candidate.temp_min = value; break;
+		case CONFIG_TEMP_MAX: candidate.temp_max = value; break;
+		case CONFIG_HUM_MIN: candidate.hum_min = value; break;
+		case CONFIG_HUM_MAX: candidate.hum_max = value; break;
+		case CONFIG_HYSTERESIS: candidate.hysteresis = value; break;
+		case CONFIG_SAMPLE_MS: candidate.sample_ms = value; break;
+		case CONFIG_DISPLAY_MS: candidate.display_ms = value; break;
+		case CONFIG_TELEMETRY: candidate.telemetry = (value > 255) ? 255 : value; break;
+		case CONFIG_CONFIRM: candidate.confirm = (value > 255) ? 255 : value; break;
+		case CONFIG_WINDOW: candidate.window = (value > 255) ? 255 : value; break;
+		case CONFIG_DWELL_MS: candidate.dwell_ms = value; break;
+	}
+
+	int8_t result = config_check(&candidate);
+	if (result != CONFIG_OK) {
+		return result;
+	}
+
+	config = candidate;
+	persist_saveconfig(&config, sizeof(config));  // Written in the background by the persist task
+	if (config_callback) {
+		config_callback(key);
+	}
+	return CONFIG_OK;
+}
+
+/**
+ * Function: Returns a setting.
+ * Argument: Setting, CONFIG_TEMP_MIN up to CONFIG_DWELL_MS.
+ * Returns: value, limits in the unit of the readings, 0 for an unknown setting.
+ */
+int32_t config_get(uint8_t key) {
+	switch (key) {
+		case CONFIG_TEMP_MIN: return config.temp_min;
+		case CONFIG_TEMP_MAX: return config.temp_max;
+		case CONFIG_HUM_MIN: return config.hum_min;
+		case CONFIG_HUM_MAX: return config.hum_max;
+		case CONFIG_HYSTERESIS: return config.hysteresis;
+		case CONFIG_SAMPLE_MS: return config.sample_ms;
+		case CONFIG_DISPLAY_MS: return config.display_ms;
+		case CONFIG_TELEMETRY: return config.telemetry;
+		case CONFIG_CONFIRM: return config.confirm;
+		case CONFIG_WINDOW: return config.window;
+		case CONFIG_DWELL_MS: return config.dwell_ms;
+	}
+	return 0;
+}
+
+/**
+ * Function: Tells how a setting is scaled.
+ * Argument: Setting.
+ * Returns: digits after the decimal point, DHT_DECIMALS for the limits and hysteresis.
+ */
+uint8_t config_decimals(uint8_t key) {
+	return (key <= CONFIG_HYSTERESIS) ? DHT_DECIMALS : 0;
+}
+
+/**
+ * Function: Sets a function that is called after a setting changed, to apply it.
+ * Argument: Function getting the setting, or 0 for none.
+ * Returns: None.
+ */
+void config_setcallback(void (*callback)(uint8_t key)) {
+	config_callback = callback;
+}
@@ -0,0 +1,63 @@
+/**
+ * Title:   	Run-time configuration
+ *
+ * Settings that can be changed without reflashing, kept in the configuration block
+ * of the EEPROM. Every change goes through config_set(), which checks the new value
+ * against the other settings, so the configuration is valid at all times.
+ */
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <stdint.h>
+
+#include "alarm.h"
+
+//limit value meaning no limit
+#define CONFIG_NOLIMIT ALARM_NOLIMIT
+
+//settings
+#define CONFIG_TEMP_MIN 0
+#define CONFIG_TEMP_MAX 1
+#define CONFIG_HUM_MIN 2
+#define CONFIG_HUM_MAX 3
+#define CONFIG_HYSTERESIS 4
+#define CONFIG_SAMPLE_MS 5
+#define CONFIG_DISPLAY_MS 6
+#define CONFIG_TELEMETRY 7
+#define CONFIG_CONFIRM 8
+#define CONFIG_WINDOW 9
+#define CONFIG_DWELL_MS 10
+#define CONFIG_KEYS 11
+
+//results of config_set()
+#define CONFIG_OK 0
+#define CONFIG_ERR_KEY -1
+#define CONFIG_ERR_RANGE -2
+#define CONFIG_ERR_ORDER -3
+
+typedef struct {
+	int16_t temp_min;		// alarm limits in the unit of the readings, CONFIG_NOLIMIT for none
+	int16_t temp_max;
+	int16_t hum_min;
+	int16_t hum_max;
+	int16_t hysteresis;		// distance a reading has to get back within a limit to end the alarm
+	uint16_t sample_ms;		// time between sensor readings
+	uint16_t display_ms;	// time per display step
+	uint8_t telemetry;		// TELEMETRY_OFF, TELEMETRY_BINARY or TELEMETRY_CSV
+	uint8_t confirm;		// readings out of the window that have to agree before an alarm changes
+	uint8_t window;			// readings the alarms look back on, up to ALARM_WINDOW_MAX
+	uint16_t dwell_ms;		// least time an alarm stays on or off
+} config_t;
+
+//current settings, read only, change them with config_set()
+extern config_t config;
+
+//functions
+extern void config_init(const config_t *defaults);
+extern int8_t config_set(uint8_t key, int32_t value);
+extern int32_t config_get(uint8_t key);
+extern uint8_t config_decimals(uint8_t key);
+extern void config_setcallback(void (*callback)(uint8_t key));
+
+#endif
@@ -11,46 +11,104 @@ Please refer to LICENSE file for licensing information.
 #include <stdio.h>
 #include <string.h>
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include <util/delay.h>
 
 #include "dht.h"
+#include "profile.h"
+
+//asynchronous reader states
+#define DHT_STATE_IDLE 0
+#define DHT_STATE_START 1 //start pulse is being sent
+#define DHT_STATE_READ 2 //sensor is sending data, edges are timestamped
+#define DHT_STATE_DONE 3 //all pulses are received
+
+static volatile uint8_t dht_state = DHT_STATE_IDLE;
+static uint32_t dht_statetime = 0; //millis when the current state started
+static volatile uint8_t dht_line = 0; //pin mask of the sensor that is being read
+static uint8_t dht_type = DHT_DHT11; //type of the sensor that is being read
+static volatile uint8_t dht_pulses[DHT_PULSES]; //high pulse widths in us
+static volatile uint8_t dht_pulsecount = 0;
+static volatile uint8_t dht_falls = 0; //falling edges seen, the first one is the sensor response
+static volatile uint16_t dht_risetime = 0; //timer value of the last rising edge
+static uint8_t dht_resultready = 0;
+static dht_value_t dht_resulttemperature = 0;
+static dht_value_t dht_resulthumidity = 0;
+static void (*dht_callback)(int8_t status) = 0;
 
 /*
- * get data from sensor
+ * convert the received bytes of a sensor type, returns -1 on checksum error
  */
-#if DHT_FLOAT == 1
-int8_t dht_getdata(float *temperature, float *humidity) {
-#elif DHT_FLOAT == 0
-int8_t dht_getdata(int8_t *temperature, int8_t *humidity) {
-#endif
+static int8_t dht_decode(uint8_t bits[5], uint8_t type, dht_value_t *temperature, dht_value_t *humidity) {
+	//check checksum
+	if ((uint8_t)(bits[0] + bits[1] + bits[2] + bits[3]) != bits[4])
+		return -1;
+
+	//return temperature and humidity
+	if(type == DHT_DHT11) {
+		*temperature = bits[2] * DHT_SCALE;
+		*humidity = bits[0] * DHT_SCALE;
+		return 0;
+	}
+
+	uint16_t rawhumidity = bits[0]<<8 | bits[1];
+	uint16_t rawtemperature = bits[2]<<8 | bits[3];
+	#if DHT_FLOAT == 1
+	if(rawtemperature & 0x8000) {
+		*temperature = (float)((rawtemperature & 0x7FFF) / 10.0) * -1.0;
+	} else {
+		*temperature = (float)(rawtemperature)/10.0;
+	}
+	*humidity = (float)(rawhumidity)/10.0;
+	#else
+	//the sensor already sends tenths, only the sign bit needs converting
+	int16_t tenths = rawtemperature & 0x7FFF;
+	if(rawtemperature & 0x8000)
+		tenths = -tenths;
+	#if DHT_FIXED == 1
+	*temperature = tenths;
+	*humidity = rawhumidity;
+	#else
+	//rounded to whole units, like a DHT11 reads
+	*temperature = (tenths + ((tenths < 0) ? -5 : 5)) / 10;
+	*humidity = (rawhumidity + 5) / 10;
+	#endif
+	#endif
+	return 0;
+}
+
+/*
+ * get data from sensor, blocking
+ */
+static int8_t dht_readdata(uint8_t pin, uint8_t type, dht_value_t *temperature, dht_value_t *humidity) {
+	uint8_t line = (1<<pin);
 	uint8_t bits[5];
 	uint8_t i,j = 0;
 
 	memset(bits, 0, sizeof(bits));
 
 	//reset port
-	DHT_DDR |= (1<<DHT_INPUTPIN); //output
-	DHT_PORT |= (1<<DHT_INPUTPIN); //high
+	DHT_DDR |= line; //output
+	DHT_PORT |= line; //high
 	_delay_ms(100);
 
 	//send request
-	DHT_PORT &= ~(1<<DHT_INPUTPIN); //low
-	#if DHT_TYPE == DHT_DHT11
-	_delay_ms(18);
-	#elif DHT_TYPE == DHT_DHT22
-	_delay_us(500);
-	#endif
-	DHT_PORT |= (1<<DHT_INPUTPIN); //high
-	DHT_DDR &= ~(1<<DHT_INPUTPIN); //input
+	DHT_PORT &= ~line; //low
+	if(type == DHT_DHT11)
+		_delay_ms(18);
+	else
+		_delay_us(500);
+	DHT_PORT |= line; //high
+	DHT_DDR &= ~line; //input
 	_delay_us(40);
 
 	//check start condition 1
-	if((DHT_PIN & (1<<DHT_INPUTPIN))) {
+	if((DHT_PIN & line)) {
 		return -1;
 	}
 	_delay_us(80);
 	//check start condition 2
-	if(!(DHT_PIN & (1<<DHT_INPUTPIN))) {
+	if(!(DHT_PIN & line)) {
 		return -1;
 	}
 	_delay_us(80);
@@ -61,17 +119,17 @@ int8_t dht_getdata(int8_t *temperature, int8_t *humidity) {
 		uint8_t result=0;
 		for(i=0; i<8; i++) {//read every bit
 			timeoutcounter = 0;
-			while(!(DHT_PIN & (1<<DHT_INPUTPIN))) { //wait for an high input (non blocking)
+			while(!(DHT_PIN & line)) { //wait for an high input (non blocking)
 				timeoutcounter++;
 				if(timeoutcounter > DHT_TIMEOUT) {
 					return -1; //timeout
 				}
 			}
 			_delay_us(30);
-			if(DHT_PIN & (1<<DHT_INPUTPIN)) //if input is high after 30 us, get result
+			if(DHT_PIN & line) //if input is high after 30 us, get result
 				result |= (1<<(7-i));
 			timeoutcounter = 0;
-			while(DHT_PIN & (1<<DHT_INPUTPIN)) { //wait until input get low (non blocking)
+			while(DHT_PIN & line) { //wait until input get low (non blocking)
 				timeoutcounter++;
 				if(timeoutcounter > DHT_TIMEOUT) {
 					return -1; //timeout
@@ -82,67 +140,185 @@ int8_t dht_getdata(int8_t *temperature, int8_t *humidity) {
 	}
 
 	//reset port
-	DHT_DDR |= (1<<DHT_INPUTPIN); //output
-	DHT_PORT |= (1<<DHT_INPUTPIN); //low
+	DHT_DDR |= line; //output
+	DHT_PORT |= line; //low
 	_delay_ms(100);
 
-	//check checksum
-	if ((uint8_t)(bits[0] + bits[1] + bits[2] + bits[3]) == bits[4]) {
-		//return temperature and humidity
-		#if DHT_TYPE == DHT_DHT11
-		*temperature = bits[2];
-		*humidity = bits[0];
-		#elif DHT_TYPE == DHT_DHT22
-		uint16_t rawhumidity = bits[0]<<8 | bits[1];
-		uint16_t rawtemperature = bits[2]<<8 | bits[3];
-		if(rawtemperature & 0x8000) {
-			*temperature = (float)((rawtemperature & 0x7FFF) / 10.0) * -1.0;
-		} else {
-			*temperature = (float)(rawtemperature)/10.0;
+	return dht_decode(bits, type, temperature, humidity);
+}
+
+/*
+ * get data from the sensor on a pin of DHT_PORT, blocking
+ */
+int8_t dht_getdata(uint8_t pin, uint8_t type, dht_value_t *temperature, dht_value_t *humidity) {
+	PROFILE_BEGIN(PROFILE_DHT_GETDATA);
+	int8_t status = dht_readdata(pin, type, temperature, humidity);
+	PROFILE_END(PROFILE_DHT_GETDATA);
+	return status;
+}
+
+/*
+ * pin change on the sensor line, timestamp the edge
+ */
+ISR(DHT_PCINT_vect) {
+	uint16_t now = DHT_TIMER;
+	PROFILE_BEGIN(PROFILE_DHT_EDGE);
+
+	if(dht_state != DHT_STATE_READ) {
+		PROFILE_END(PROFILE_DHT_EDGE);
+		return;
+	}
+
+	if(DHT_PIN & dht_line) { //rising edge, a high pulse starts
+		dht_risetime = now;
+	} else { //falling edge, a high pulse ends
+		if(dht_falls > 0) { //the first falling edge is the sensor pulling the line low as a response
+			uint16_t width = now - dht_risetime;
+			if(now < dht_risetime)
+				width += DHT_TIMERTOP;
+			width /= DHT_TIMERCOUNTSPERUS;
+			dht_pulses[dht_pulsecount++] = (width > 255) ? 255 : width;
+			if(dht_pulsecount >= DHT_PULSES) {
+				DHT_PCMSK &= ~dht_line; //all pulses received
+				dht_state = DHT_STATE_DONE;
+			}
 		}
-		*humidity = (float)(rawhumidity)/10.0;
-		#endif
-		return 0;
+		dht_falls++;
 	}
+	PROFILE_END(PROFILE_DHT_EDGE);
+}
+
+/*
+ * init the asynchronous reader, pins is the mask of the sensor lines on DHT_PORT
+ */
+void dht_init(uint8_t pins) {
+	//idle lines high
+	DHT_DDR |= pins; //output
+	DHT_PORT |= pins; //high
+	PCICR |= (1<<DHT_PCICR_BIT);
+	dht_state = DHT_STATE_IDLE;
+}
 
-	return -1;
+/*
+ * start a reading of the sensor of a type on a pin of DHT_PORT, returns -1 when a reading is already busy
+ */
+int8_t dht_start(uint8_t pin, uint8_t type) {
+	if(dht_state != DHT_STATE_IDLE)
+		return -1;
+
+	dht_line = (1<<pin);
+	dht_type = type;
+
+	//send request
+	DHT_DDR |= dht_line; //output
+	DHT_PORT &= ~dht_line; //low
+	dht_statetime = sched_millis();
+	dht_state = DHT_STATE_START;
+	return 0;
 }
 
 /*
- * get temperature
+ * finish a reading, waiting for the sensor to answer again
  */
-#if DHT_FLOAT == 1
-int8_t dht_gettemperature(float *temperature) {
-	float humidity = 0;
-#elif DHT_FLOAT == 0
-int8_t dht_gettemperature(int8_t *temperature) {
-	int8_t humidity = 0;
-#endif
-	return dht_getdata(temperature, &humidity);
+static int8_t dht_finish(int8_t status) {
+	DHT_PCMSK &= ~dht_line;
+	//reset port
+	DHT_DDR |= dht_line; //output
+	DHT_PORT |= dht_line; //high
+	dht_state = DHT_STATE_IDLE;
+
+	if(dht_callback)
+		dht_callback(status);
+	return status;
+}
+
+/*
+ * advance the asynchronous reader, call this every millisecond
+ * returns DHT_READY or DHT_ERROR once when a reading finished, else DHT_BUSY or DHT_IDLE
+ */
+int8_t dht_poll(void) {
+	uint8_t state = dht_state;
+
+	if(state == DHT_STATE_START) {
+		uint8_t startms = (dht_type == DHT_DHT11) ? DHT_DHT11_STARTMS : DHT_DHT22_STARTMS;
+		//the start came somewhere within a tick, one more tick makes sure the pulse lasts at least startms
+		if(sched_millis() - dht_statetime > startms) {
+			//release the line and timestamp the sensor edges
+			dht_pulsecount = 0;
+			dht_falls = 0;
+			dht_risetime = DHT_TIMER;
+			dht_statetime = sched_millis();
+			dht_state = DHT_STATE_READ;
+			DHT_PORT |= dht_line; //high
+			DHT_DDR &= ~dht_line; //input, pull-up keeps it high
+			PCIFR |= (1<<DHT_PCICR_BIT); //ignore edges from before the release
+			DHT_PCMSK |= dht_line;
+		}
+		return DHT_BUSY;
+	}
+
+	if(state == DHT_STATE_READ) {
+		if(sched_millis() - dht_statetime > DHT_READMS)
+			return dht_finish(DHT_ERROR); //timeout
+		return DHT_BUSY;
+	}
+
+	if(state == DHT_STATE_DONE) {
+		uint8_t bits[5];
+		uint8_t i = 0;
+		int8_t status;
+		PROFILE_BEGIN(PROFILE_DHT_POLL);
+
+		//the first pulse is the 80us response, the others hold the data msb first
+		memset(bits, 0, sizeof(bits));
+		for(i=0; i<40; i++) {
+			if(dht_pulses[i+1] > DHT_BITUS)
+				bits[i/8] |= (1<<(7-(i%8)));
+		}
+
+		if(dht_decode(bits, dht_type, &dht_resulttemperature, &dht_resulthumidity) == -1) {
+			status = DHT_ERROR;
+		} else {
+			dht_resultready = 1;
+			status = DHT_READY;
+		}
+		PROFILE_END(PROFILE_DHT_POLL);
+		return dht_finish(status);
+	}
+
+	return DHT_IDLE;
 }
 
 /*
- * get humidity
+ * check if a new reading is ready
  */
-#if DHT_FLOAT == 1
-int8_t dht_gethumidity(float *humidity) {
-	float temperature = 0;
-#elif DHT_FLOAT == 0
-int8_t dht_gethumidity(int8_t *humidity) {
-	int8_t temperature = 0;
-#endif
-	return dht_getdata(&temperature, humidity);
+uint8_t dht_ready(void) {
+	return dht_resultready;
 }
 
 /*
- * get temperature and humidity
+ * get the last reading of the asynchronous reader, returns -1 when there is no new reading
  */
-#if DHT_FLOAT == 1
-int8_t dht_gettemperaturehumidity(float *temperature, float *humidity) {
-#elif DHT_FLOAT == 0
-	int8_t dht_gettemperaturehumidity(int8_t *temperature, int8_t *humidity) {
-#endif
-	return dht_getdata(temperature, humidity);
+int8_t dht_getresult(dht_value_t *temperature, dht_value_t *humidity) {
+	if(!dht_resultready)
+		return -1;
+	*temperature = dht_resulttemperature;
+	*humidity = dht_resulthumidity;
+	dht_resultready = 0;
+	return 0;
 }
 
+/*
+ * set a function called with DHT_READY or DHT_ERROR when a reading finished
+ */
+void dht_setcallback(void (*callback)(int8_t status)) {
+	dht_callback = callback;
+}
 
+/*
+ * get the high pulse widths in us of the last reading, for diagnostics
+ */
+const uint8_t *dht_getpulses(uint8_t *count) {
+	*count = dht_pulsecount;
+	return (const uint8_t *)dht_pulses;
+}
@@ -17,36 +17,97 @@ References:
 #include <stdio.h>
 #include <avr/io.h>
 
-//setup port
-#define DHT_DDR DDRD
-#define DHT_PORT PORTD
-#define DHT_PIN PIND
-#define DHT_INPUTPIN PD6
+#include "sched.h"
+#include "pins.h"
 
-//sensor type
+//setup port, every sensor has its own line on it, see sensor.h
+#define DHT_DDR PIN_DDRREG(BOARD_DHT1)
+#define DHT_PORT PIN_PORTREG(BOARD_DHT1)
+#define DHT_PIN PIN_INREG(BOARD_DHT1)
+
+//setup pin change interrupt of the port, used by the asynchronous reader
+//the bits of the mask register belong to the pins of the port with the same number
+#define DHT_PCICR_BIT PIN_PCIE(BOARD_DHT1)
+#define DHT_PCMSK PIN_PCMSK(BOARD_DHT1)
+#define DHT_PCINT_vect PIN_PCINTVECT(BOARD_DHT1)
+
+//setup edge timestamps, a counter running from 0 to DHT_TIMERTOP-1
+#define DHT_TIMER TCNT1
+#define DHT_TIMERTOP SCHED_COUNTSPERMS
+#define DHT_TIMERCOUNTSPERUS SCHED_COUNTSPERUS
+
+//sensor types
 #define DHT_DHT11 1
 #define DHT_DHT22 2
+
+//precision of the returned values, DHT_DHT22 keeps the tenths of DHT22 sensors
+//with DHT_DHT11 every reading is in whole units, set DHT_DHT22 when one is connected
 #define DHT_TYPE DHT_DHT11
 
-//enable decimal precision (float)
+//enable decimal precision, either as float or as fixed-point tenths of a unit (int16_t)
+//fixed-point keeps the soft-float library out, only the DHT22 has decimals
 #if DHT_TYPE == DHT_DHT11
 #define DHT_FLOAT 0
+#define DHT_FIXED 0
 #elif DHT_TYPE == DHT_DHT22
-#define DHT_FLOAT 1
+#define DHT_FLOAT 0
+#define DHT_FIXED 1
+#endif
+
+#if DHT_FLOAT == 1 && DHT_FIXED == 1
+#error "DHT_FLOAT and DHT_FIXED can not be enabled both"
+#endif
+
+//representation of the returned values, a reading equals value / DHT_SCALE
+#if DHT_FIXED == 1
+#define DHT_SCALE 10
+#define DHT_DECIMALS 1
+#else
+#define DHT_SCALE 1
+#define DHT_DECIMALS 0
 #endif
 
 //timeout retries
 #define DHT_TIMEOUT 200
 
-//functions
+//asynchronous reader timing
+#define DHT_DHT11_STARTMS 18 //shortest start pulse, the pulse lasts up to one millisecond longer
+#define DHT_DHT22_STARTMS 1
+#define DHT_READMS 10 //maximum time for the sensor to send all data
+#define DHT_BITUS 50 //high pulses longer than this are a 1
+#define DHT_PULSES 41 //response pulse plus 40 data bits
+
+//time between two readings of a sensor, the sensors give bad data when read faster
+#define DHT_DHT11_SAMPLEMS 1000
+#define DHT_DHT22_SAMPLEMS 2000
+#if DHT_TYPE == DHT_DHT11
+#define DHT_SAMPLEMS DHT_DHT11_SAMPLEMS
+#elif DHT_TYPE == DHT_DHT22
+#define DHT_SAMPLEMS DHT_DHT22_SAMPLEMS
+#endif
+
+//asynchronous reader status
+#define DHT_ERROR -1
+#define DHT_IDLE 0
+#define DHT_BUSY 1
+#define DHT_READY 2
+
 #if DHT_FLOAT == 1
-extern int8_t dht_gettemperature(float *temperature);
-extern int8_t dht_gethumidity(float *humidity);
-extern int8_t dht_gettemperaturehumidity(float *temperature, float *humidity);
-#elif DHT_FLOAT == 0
-extern int8_t dht_gettemperature(int8_t *temperature);
-extern int8_t dht_gethumidity(int8_t *humidity);
-extern int8_t dht_gettemperaturehumidity(int8_t *temperature, int8_t *humidity);
+typedef float dht_value_t;
+#elif DHT_FIXED == 1
+typedef int16_t dht_value_t;
+#else
+typedef int8_t dht_value_t;
 #endif
 
+//functions
+extern int8_t dht_getdata(uint8_t pin, uint8_t type, dht_value_t *temperature, dht_value_t *humidity);
+extern void dht_init(uint8_t pins);
+extern int8_t dht_start(uint8_t pin, uint8_t type);
+extern int8_t dht_poll(void);
+extern uint8_t dht_ready(void);
+extern int8_t dht_getresult(dht_value_t *temperature, dht_value_t *humidity);
+extern void dht_setcallback(void (*callback)(int8_t status));
+extern const uint8_t *dht_getpulses(uint8_t *count);
+
 #endif
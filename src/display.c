@@ -0,0 +1,228 @@
+/**
+ * Title:   	LCD page rotation
+ *
+ * See display.h for how events, pages and the rotation work together.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "display.h"
+#include "hd44780.h"
+#include "sched.h"
+#include "profile.h"
+
+static const display_page_t *display_pages = 0;	// page table, in flash
+static uint8_t display_count = 0;				// pages per sensor
+static uint8_t display_sensors = 0;
+static uint16_t display_step = 0;				// time a page stays on in the rotation
+static display_callback_t display_callback = 0;
+
+static uint8_t display_pending[DISPLAY_MAXSENSORS];	// events raised since the last check
+static uint8_t display_page = 0;				// page on the screen
+static uint8_t display_sensor = 0;				// sensor of the page on the screen
+static uint8_t display_shown = 0;				// a page is on the screen
+static uint32_t display_since = 0;				// millis the page came on
+
+/**
+ * Function: Copies a page of the table from flash.
+ * Arguments:
+ * 		1. Page number.
+ * 		2. Receives the page.
+ * Returns: None.
+ */
+static void display_read(uint8_t page, display_page_t *entry) {
+	memcpy_P(entry, &display_pages[page], sizeof(display_page_t));
+}
+
+/**
+ * Function: Checks if a page is part of the rotation right now.
+ * Arguments:
+ * 		1. Page.
+ * 		2. Sensor.
+ * Returns: 1 when visible, 0 when it is skipped.
+ */
+static uint8_t display_visible(const display_page_t *entry, uint8_t sensor) {
+	return entry->visible == 0 || entry->visible(sensor);
+}
+
+/**
+ * Function: Puts a page on the screen.
+ * Arguments:
+ * 		1. Page number.
+ * 		2. Sensor.
+ * 		3. Current millis.
+ * Returns: None.
+ */
+static void display_show(uint8_t page, uint8_t sensor, uint32_t now) {
+	display_page_t entry;
+
+	display_read(page, &entry);
+	display_page = page;
+	display_sensor = sensor;
+	display_since = now;
+	display_shown = 1;
+
+	entry.draw(sensor);
+	if (entry.enter) {
+		entry.enter(sensor);
+	}
+	if (display_callback) {
+		display_callback();
+	}
+}
+
+/**
+ * Function: Puts the next visible page of the rotation on the screen, after the pages of a
+ * sensor come those of the next one. The same page is drawn again when no other one is visible.
+ * Argument: Current millis.
+ * Returns: None.
+ */
+static void display_next(uint32_t now) {
+	display_page_t entry;
+	uint8_t page = display_page;
+	uint8_t sensor = display_sensor;
+
+	for (uint16_t i = 0; i < (uint16_t)display_count * display_sensors; i++) {
+		if (++page >= display_count) {
+			page = 0;
+			if (++sensor >= display_sensors) {
+				sensor = 0;
+			}
+		}
+		display_read(page, &entry);
+		if (display_visible(&entry, sensor)) {
+			display_show(page, sensor, now);
+			return;
+		}
+	}
+	display_show(display_page, display_sensor, now);
+}
+
+/**
+ * Function: Looks for an urgent page that the raised events made visible.
+ * Arguments:
+ * 		1. Receives the page number.
+ * 		2. Receives the sensor.
+ * Returns: 1 when one is found, 0 otherwise.
+ */
+static uint8_t display_urgent(uint8_t *page, uint8_t *sensor) {
+	display_page_t entry;
+
+	for (uint8_t s = 0; s < display_sensors; s++) {
+		if (display_pending[s] == 0) {
+			continue;
+		}
+		for (uint8_t p = 0; p < display_count; p++) {
+			display_read(p, &entry);
+			if (entry.urgent && (entry.events & display_pending[s]) && display_visible(&entry, s)) {
+				*page = p;
+				*sensor = s;
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/**
+ * Function: Sets up the rotation, the first page comes on at the first run of display_task().
+ * Arguments:
+ * 		1. Page table in flash, at least one page has to be always visible.
+ * 		2. Pages in the table.
+ * 		3. Sensors, at most DISPLAY_MAXSENSORS. Every sensor gets all pages.
+ * 		4. Time every page stays on in the rotation.
+ * Returns: None.
+ */
+void display_init(const display_page_t *pages, uint8_t count, uint8_t sensors, uint16_t step_ms) {
+	display_pages = pages;
+	display_count = count;
+	display_sensors = (sensors > DISPLAY_MAXSENSORS) ? DISPLAY_MAXSENSORS : sensors;
+	display_step = step_ms;
+	display_page = count - 1;  // The rotation starts at the first page of the first sensor
+	display_sensor = display_sensors - 1;
+	display_shown = 0;
+	for (uint8_t i = 0; i < DISPLAY_MAXSENSORS; i++) {
+		display_pending[i] = 0;
+	}
+}
+
+/**
+ * Function: Sets the time every page stays on, from the next page on.
+ * Argument: Time in milliseconds.
+ * Returns: None.
+ */
+void display_setstep(uint16_t step_ms) {
+	display_step = step_ms;
+}
+
+/**
+ * Function: Sets a function that is called every time a page comes on.
+ * Argument: Function, or NULL for none.
+ * Returns: None.
+ */
+void display_setcallback(display_callback_t callback) {
+	display_callback = callback;
+}
+
+/**
+ * Function: Raises change events, the page on the screen is redrawn at the next check when it
+ * shows one of them. Not for use in an interrupt.
+ * Arguments:
+ * 		1. Sensor, or DISPLAY_SENSORS for all of them.
+ * 		2. DISPLAY_ events.
+ * Returns: None.
+ */
+void display_event(uint8_t sensor, uint8_t events) {
+	if (sensor == DISPLAY_SENSORS) {
+		for (uint8_t i = 0; i < display_sensors; i++) {
+			display_pending[i] |= events;
+		}
+	}
+	else if (sensor < display_sensors) {
+		display_pending[sensor] |= events;
+	}
+}
+
+/**
+ * Task: Handles the raised events and moves the rotation on, only sends the LCD what changed.
+ * Runs every DISPLAY_POLL_MS milliseconds.
+ */
+void display_task(void) {
+	PROFILE_BEGIN(PROFILE_DISPLAY);
+
+	uint32_t now = sched_millis();
+	display_page_t entry;
+	uint8_t page;
+	uint8_t sensor;
+	uint8_t drawn = 1;
+
+	display_read(display_page, &entry);
+
+	if (!display_shown) {
+		display_next(now);
+	}
+	// An alarm preempts the rotation, except another urgent page that is already on
+	else if (!(entry.urgent && display_visible(&entry, display_sensor)) && display_urgent(&page, &sensor)) {
+		display_show(page, sensor, now);
+	}
+	// A page that is no longer visible, like an alarm that ended, or one that was on long enough
+	else if (!display_visible(&entry, display_sensor) || now - display_since >= display_step) {
+		display_next(now);
+	}
+	else if (entry.events & display_pending[display_sensor]) {
+		entry.draw(display_sensor);
+	}
+	else {
+		drawn = 0;
+	}
+
+	for (uint8_t i = 0; i < display_sensors; i++) {
+		display_pending[i] = 0;
+	}
+	if (drawn) {
+		lcd_buffer_flush();  // Only the characters that changed
+	}
+
+	PROFILE_END(PROFILE_DISPLAY);
+}
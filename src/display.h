@@ -0,0 +1,56 @@
+/**
+ * Title:   	LCD page rotation
+ *
+ * Model/view split of the LCD. The readings, alarms and history raise change events
+ * for a sensor with display_event(), the pages of a table in flash say which events
+ * change them. display_task() redraws the page on the screen only when one of its
+ * events was raised for its sensor, and lcd_buffer_flush() then sends only the fields
+ * that changed.
+ *
+ * The pages are shown in turn for every sensor, each one for the display step time.
+ * A page with a visible() check is skipped while it returns 0, like an alarm page
+ * without an alarm. An urgent page comes on as soon as an event makes it visible,
+ * so an alarm shows up within DISPLAY_POLL_MS instead of at the next display step.
+ */
+
+#ifndef DISPLAY_H_
+#define DISPLAY_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+//change events, one bit each
+#define DISPLAY_READING 0x01		// a new accepted reading
+#define DISPLAY_ALARM 0x02			// an alarm state changed
+#define DISPLAY_HISTORY 0x04		// a new history sample or extreme
+#define DISPLAY_ERROR 0x08			// a reading failed, or worked again after failing
+#define DISPLAY_SETTINGS 0x10		// the limits changed
+#define DISPLAY_ALL 0xFF
+
+//sensor argument of display_event() for all sensors
+#define DISPLAY_SENSORS 0xFF
+
+//time between two checks for events, the latency of a redraw
+#define DISPLAY_POLL_MS 10
+
+//most sensors the rotation goes through, one bit of pending events each
+#define DISPLAY_MAXSENSORS 8
+
+typedef struct {
+	void (*draw)(uint8_t sensor);		// fills the frame buffer with the page
+	uint8_t (*visible)(uint8_t sensor);	// 1 when the page is part of the rotation, 0 to skip it, NULL for always
+	void (*enter)(uint8_t sensor);		// called when the page comes on, for sounds, may be NULL
+	uint8_t events;						// events that change the page
+	uint8_t urgent;						// 1 to come on right away once an event makes it visible
+} display_page_t;
+
+typedef void (*display_callback_t)(void);
+
+//functions
+extern void display_init(const display_page_t *pages, uint8_t count, uint8_t sensors, uint16_t step_ms);
+extern void display_setstep(uint16_t step_ms);
+extern void display_setcallback(display_callback_t callback);
+extern void display_event(uint8_t sensor, uint8_t events);
+extern void display_task(void);
+
+#endif
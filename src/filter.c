@@ -0,0 +1,153 @@
+/**
+ * Title:   	Reading filter
+ *
+ * See filter.h for the stages.
+ */
+
+#include <stdint.h>
+
+#include "filter.h"
+
+/**
+ * Function: Distance between two readings.
+ * Arguments:
+ * 		1. Reading.
+ * 		2. Other reading.
+ * Returns: Absolute difference, without overflow.
+ */
+static inline uint16_t filter_distance(int16_t a, int16_t b) {
+	int32_t difference = (int32_t)a - b;
+	return (difference < 0) ? -difference : difference;
+}
+
+/**
+ * Function: Rate stage, checks a reading against the last accepted one.
+ * Arguments:
+ * 		1. Filter.
+ * 		2. Reading.
+ * Returns: 0 when accepted, -1 when rejected.
+ */
+static int8_t filter_rate(filter_t *filter, int16_t value) {
+	if (!filter->primed || filter_distance(value, filter->reference) <= filter->max_step) {
+		filter->reference = value;
+		filter->pending_count = 0;
+		return 0;
+	}
+
+	// Readings that are rejected but agree with each other are a real change, like a door opening
+	if (filter->pending_count > 0 && filter_distance(value, filter->pending) <= filter->max_step) {
+		filter->pending_count++;
+	}
+	else {
+		filter->pending_count = 1;
+	}
+	filter->pending = value;
+
+	if (filter->pending_count >= filter->resync) {
+		filter->reference = value;
+		filter->pending_count = 0;
+		filter->resyncs++;
+		return 0;
+	}
+
+	filter->rejected++;
+	return -1;
+}
+
+/**
+ * Function: Median stage, adds a reading to the window.
+ * Arguments:
+ * 		1. Filter.
+ * 		2. Reading.
+ * Returns: Median of the readings in the window, the lower one of the middle two for an even count.
+ */
+static int16_t filter_median(filter_t *filter, int16_t value) {
+	int16_t sorted[FILTER_MEDIANSIZE];
+
+	filter->window[filter->window_next] = value;
+	filter->window_next = (filter->window_next + 1) % FILTER_MEDIANSIZE;
+	if (filter->window_count < FILTER_MEDIANSIZE) {
+		filter->window_count++;
+	}
+
+	// Insertion sort of at most FILTER_MEDIANSIZE readings
+	for (uint8_t i = 0; i < filter->window_count; i++) {
+		int16_t v = filter->window[i];
+		uint8_t j = i;
+
+		while (j > 0 && sorted[j - 1] > v) {
+			sorted[j] = sorted[j - 1];
+			j--;
+		}
+		sorted[j] = v;
+	}
+	return sorted[(filter->window_count - 1) / 2];
+}
+
+/**
+ * Function: Average stage, adds a reading to the moving average.
+ * Arguments:
+ * 		1. Filter.
+ * 		2. Reading.
+ * Returns: Rounded average.
+ */
+static int16_t filter_ema(filter_t *filter, int16_t value) {
+	if (filter->ema_shift == 0) {
+		return value;
+	}
+	if (!filter->primed) {
+		filter->ema = (int32_t)value << filter->ema_shift;
+	}
+	else {
+		filter->ema += value - (filter->ema >> filter->ema_shift);
+	}
+	return (filter->ema + (1L << (filter->ema_shift - 1))) >> filter->ema_shift;
+}
+
+/**
+ * Function: Sets up a filter, with no readings yet.
+ * Arguments:
+ * 		1. Filter.
+ * 		2. Stages, FILTER_ flags.
+ * 		3. Largest accepted change between two readings, for FILTER_RATE.
+ * 		4. Agreeing rejected readings after which a change is followed, at least 1, for FILTER_RATE.
+ * 		5. Weight of a new reading is 1 / 2^ema_shift, 0 up to 8, for FILTER_EMA.
+ * Returns: None.
+ */
+void filter_init(filter_t *filter, uint8_t stages, int16_t max_step, uint8_t resync, uint8_t ema_shift) {
+	filter->stages = stages;
+	filter->max_step = max_step;
+	filter->resync = (resync < 1) ? 1 : resync;
+	filter->ema_shift = (ema_shift > 8) ? 8 : ema_shift;
+
+	filter->primed = 0;
+	filter->pending_count = 0;
+	filter->window_count = 0;
+	filter->window_next = 0;
+	filter->rejected = 0;
+	filter->resyncs = 0;
+}
+
+/**
+ * Function: Runs a reading through the filter.
+ * Arguments:
+ * 		1. Filter.
+ * 		2. Reading.
+ * 		3. Receives the filtered reading, left untouched when the reading is rejected.
+ * Returns: 0 when accepted, -1 when rejected.
+ */
+int8_t filter_add(filter_t *filter, int16_t value, int16_t *result) {
+	if ((filter->stages & FILTER_RATE) && filter_rate(filter, value) != 0) {
+		return -1;
+	}
+	if (filter->stages & FILTER_MEDIAN) {
+		value = filter_median(filter, value);
+	}
+	if (filter->stages & FILTER_EMA) {
+		value = filter_ema(filter, value);
+	}
+
+	filter->primed = 1;
+	*result = value;
+	return 0;
+}
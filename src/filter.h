@@ -0,0 +1,52 @@
+/**
+ * Title:   	Reading filter
+ *
+ * Cleans up a stream of readings with up to three stages, applied in this order:
+ * 		FILTER_RATE		rejects a reading that changed more than max_step since the last
+ * 						accepted one. After `resync` rejected readings that agree with each
+ * 						other the change is taken as real and the filter follows it.
+ * 		FILTER_MEDIAN	median of the last FILTER_MEDIANSIZE accepted readings.
+ * 		FILTER_EMA		exponential moving average with a weight of 1 / 2^ema_shift.
+ * Every stage runs in constant time, the state of a filter is a filter_t of its own.
+ */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include <stdint.h>
+
+//stages, combine them with |
+#define FILTER_RATE 0x01
+#define FILTER_MEDIAN 0x02
+#define FILTER_EMA 0x04
+
+//readings the median is taken over
+#define FILTER_MEDIANSIZE 5
+
+typedef struct {
+	// settings
+	uint8_t stages;
+	int16_t max_step;			// largest accepted change between two readings
+	uint8_t resync;				// agreeing rejected readings after which the filter follows the change
+	uint8_t ema_shift;
+
+	// state
+	uint8_t primed;				// set once a reading was accepted
+	int16_t reference;			// last accepted reading
+	int16_t pending;			// last rejected reading
+	uint8_t pending_count;		// rejected readings in a row that agree with each other
+	int16_t window[FILTER_MEDIANSIZE];
+	uint8_t window_count;
+	uint8_t window_next;
+	int32_t ema;				// average times 2^ema_shift
+
+	// counters, read only
+	uint16_t rejected;			// readings the rate stage threw away
+	uint16_t resyncs;			// times the rate stage followed a change
+} filter_t;
+
+//functions
+extern void filter_init(filter_t *filter, uint8_t stages, int16_t max_step, uint8_t resync, uint8_t ema_shift);
+extern int8_t filter_add(filter_t *filter, int16_t value, int16_t *result);
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * Title:   	Number formatting
+ *
+ * See format.h.
+ */
+
+#include <stdint.h>
+
+#include "format.h"
+
+/**
+ * Function: Writes a signed fixed-point number, not terminated.
+ * Arguments:
+ * 		1. Text with room for FORMAT_MAXLENGTH characters.
+ * 		2. Number in units of 10^-decimals, e.g. 235 with 1 decimal is 23.5
+ * 		3. Digits after the decimal point.
+ * Returns: amount of characters written.
+ */
+uint8_t format_number(char *text, int32_t value, uint8_t decimals) {
+	char digits[FORMAT_MAXLENGTH];
+	uint8_t n = 0;
+	uint8_t length = 0;
+	uint32_t magnitude = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+
+	do {  // Digits come out reversed
+		digits[n++] = '0' + magnitude % 10;
+		magnitude /= 10;
+		if (n == decimals) {
+			digits[n++] = '.';
+		}
+	} while (magnitude || n <= decimals + (decimals > 0));  // Keep a leading zero before the point
+
+	if (value < 0) {
+		text[length++] = '-';
+	}
+	while (n) {
+		text[length++] = digits[--n];
+	}
+	return length;
+}
+
+/**
+ * Function: Reads a signed number with at most the given amount of decimals, e.g. "-3", "21.5".
+ * Arguments:
+ * 		1. Terminated text.
+ * 		2. Digits after the decimal point of the result.
+ * 		3. Receives the number in units of 10^-decimals.
+ * Returns: 0 on success, -1 when the text is not such a number or does not fit.
+ */
+int8_t format_parse(const char *text, uint8_t decimals, int32_t *value) {
+	int32_t result = 0;
+	uint8_t negative = 0;
+	uint8_t digits = 0;
+	int8_t fraction = -1;  // digits after the point, -1 without a point
+
+	if (*text == '-') {
+		negative = 1;
+		text++;
+	}
+
+	for (; *text; text++) {
+		if (*text == '.' && fraction < 0) {
+			fraction = 0;
+		}
+		else if (*text >= '0' && *text <= '9' && fraction < (int8_t)decimals && digits < 9) {
+			result = result * 10 + (*text - '0');
+			digits++;
+			if (fraction >= 0) {
+				fraction++;
+			}
+		}
+		else {
+			return -1;
+		}
+	}
+
+	if (digits == 0) {
+		return -1;
+	}
+	for (int8_t i = (fraction < 0) ? 0 : fraction; i < (int8_t)decimals; i++) {
+		if (result > INT32_MAX / 10) {  // Nine digits fit, scaled up they may not
+			return -1;
+		}
+		result *= 10;
+	}
+
+	*value = negative ? -result : result;
+	return 0;
+}
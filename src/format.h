@@ -0,0 +1,20 @@
+/**
+ * Title:   	Number formatting
+ *
+ * Writes signed fixed-point numbers as text without pulling in vfprintf, for the
+ * serial interfaces. The LCD driver has its own, padded, variant.
+ */
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include <stdint.h>
+
+//longest number including sign and decimal point
+#define FORMAT_MAXLENGTH 12
+
+//functions
+extern uint8_t format_number(char *text, int32_t value, uint8_t decimals);
+extern int8_t format_parse(const char *text, uint8_t decimals, int32_t *value);
+
+#endif
@@ -4,9 +4,11 @@ Author :   SA Development
 Version:   1.11
 *****************************************************************************/
 
-#include "avr\pgmspace.h"
+#include "avr/pgmspace.h"
 #include "hd44780.h"
-#include "avr\sfr_defs.h"
+#include "profile.h"
+#include "avr/interrupt.h"
+#include "avr/sfr_defs.h"
 #if (USE_ADELAY_LIBRARY==1)
   #include "adelay.h"
 #else
@@ -32,7 +34,7 @@ Version:   1.11
   #error LCD_BITS is not defined or not valid.
 #endif
 
-#if !defined(WAIT_MODE) || (WAIT_MODE!=0 && WAIT_MODE!=1)
+#if !defined(WAIT_MODE) || (WAIT_MODE!=0 && WAIT_MODE!=1 && WAIT_MODE!=2)
   #error WAIT_MODE is not defined or not valid.
 #endif
 
@@ -40,14 +42,34 @@ Version:   1.11
   #error RW_LINE_IMPLEMENTED is not defined or not valid.
 #endif
 
-#if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED!=1)
-  #error WAIT_MODE=1 requires RW_LINE_IMPLEMENTED=1.
+#if (WAIT_MODE!=0 && RW_LINE_IMPLEMENTED!=1)
+  #error WAIT_MODE=1 and WAIT_MODE=2 require RW_LINE_IMPLEMENTED=1.
 #endif
 
+// Busy flag is polled in WAIT_MODE 1 and 2, fixed delays are used in WAIT_MODE 0 and after a timeout in WAIT_MODE 2
+#define LCD_WAIT_BUSYFLAG (WAIT_MODE!=0 && RW_LINE_IMPLEMENTED==1)
+#define LCD_WAIT_DELAY    (WAIT_MODE!=1 || RW_LINE_IMPLEMENTED==0)
+
 #if !defined(LCD_DISPLAYS) || (LCD_DISPLAYS<1) || (LCD_DISPLAYS>4)
   #error LCD_DISPLAYS is not defined or not valid.
 #endif
 
+#if defined(LCD_BUFFER) && LCD_BUFFER==1 && LCD_DISPLAYS>1
+  #error LCD_BUFFER=1 only supports a single display.
+#endif
+
+#if defined(LCD_ASYNC) && LCD_ASYNC==1 && ((LCD_QUEUE_SIZE & (LCD_QUEUE_SIZE-1))!=0 || LCD_QUEUE_SIZE>256)
+  #error LCD_QUEUE_SIZE must be a power of 2, at most 256.
+#endif
+
+#if !defined(LCD_GLYPHS) || (LCD_GLYPHS<0) || (LCD_GLYPHS>8)
+  #error LCD_GLYPHS must be 0 up to 8.
+#endif
+
+#if defined(LCD_ASYNC) && LCD_ASYNC==1 && LCD_DISPLAYS>1
+  #error LCD_ASYNC=1 only supports a single display.
+#endif
+
 // Constants/Macros
 #define PIN(x) (*(&x - 2))           // Address of Data Direction Register of Port X
 #define DDR(x) (*(&x - 1))           // Address of Input Register of Port X
@@ -142,14 +164,29 @@ Version:   1.11
 #define lcd_db6_ddr_set(value) if (value) lcd_db6_ddr_high(); else lcd_db6_ddr_low();
 #define lcd_db7_ddr_set(value) if (value) lcd_db7_ddr_high(); else lcd_db7_ddr_low();
 
-#if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
+#if LCD_WAIT_BUSYFLAG
 static unsigned char PrevCmdInvolvedAddressCounter=0;
 #endif
 
+#if (WAIT_MODE==2)
+static unsigned char BusyFlagFailed=0;           // Set when the busy flag timed out, delays are used from then on
+#endif
+
 #if (LCD_DISPLAYS>1)
 static unsigned char ActiveDisplay=1;
 #endif
 
+#if LCD_BUFFER==1
+#define LCD_BUFFER_LINES LCD_DISPLAY_LINES
+static char lcd_buffer[LCD_BUFFER_LINES][LCD_BUFFER_COLUMNS];   // Characters as they should be
+static char lcd_glass[LCD_BUFFER_LINES][LCD_BUFFER_COLUMNS];    // Characters as they are on the display
+static uint8_t lcd_buffer_pos=0;                                // Buffer cursor, DDRAM address
+static uint8_t lcd_address=0;                                   // Display cursor, DDRAM address
+
+// DDRAM address of the first character of every line
+static const uint8_t lcd_line_address[4]={0x00,0x40,0x00+LCD_BUFFER_COLUMNS,0x40+LCD_BUFFER_COLUMNS};
+#endif
+
 static inline void lcd_e_port_low()
 {
   #if (LCD_DISPLAYS>1)
@@ -244,18 +281,59 @@ static inline void lcd_e_ddr_high()
 
 
 /*************************************************************************
-loops while lcd is busy, returns address counter
+loops while lcd is busy, gives up after about 2ms
+Returns:  1 if the busy flag cleared, 0 on timeout
 *************************************************************************/
-#if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
+#if LCD_WAIT_BUSYFLAG
 static uint8_t lcd_read(uint8_t rs);
 
-static void lcd_waitbusy(void)
+static uint8_t lcd_waitbusy(void)
   {
-    register uint8_t c;
     unsigned int ul1=0;
 
-    while ( ((c=lcd_read(0)) & (1<<LCD_BUSY)) && ul1<((F_CPU/16384>=16)?F_CPU/16384:16))     // Wait Until Busy Flag is Cleared
-      ul1++;
+    #if (WAIT_MODE==2)
+    if (BusyFlagFailed)                               // Busy flag does not work, caller delays instead
+      return 0;
+    #endif
+
+    while (lcd_read(0) & (1<<LCD_BUSY))               // Wait Until Busy Flag is Cleared
+      {
+        if (++ul1>=((F_CPU/16384>=16)?F_CPU/16384:16))
+          {
+            #if (WAIT_MODE==2)
+            BusyFlagFailed=1;
+            #endif
+            return 0;
+          }
+      }
+
+    if (PrevCmdInvolvedAddressCounter)                // Address counter is updated shortly after the busy flag clears
+      {
+        Delay_us(5);
+        PrevCmdInvolvedAddressCounter=0;
+      }
+    return 1;
+  }
+#endif
+
+/*************************************************************************
+Delay for the worst-case execution time of the previous byte
+Only used when the busy flag is not available
+Input:    data   byte that was sent or read
+          rs     1: data, 0: instruction
+Returns:  none
+*************************************************************************/
+#if LCD_WAIT_DELAY
+static void lcd_delay(uint8_t data,uint8_t rs)
+  {
+    #if (WAIT_MODE==2)
+    if (!BusyFlagFailed)
+      return;
+    #endif
+
+    if (!rs && data<=((1<<LCD_CLR) | (1<<LCD_HOME))) // Is command clrscr or home?
+      Delay_us(1640);
+    else Delay_us(40);
   }
 #endif
 
@@ -271,20 +349,15 @@ static uint8_t lcd_read(uint8_t rs)
   {
     uint8_t data;
     
-    #if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
-    if (rs)
+    #if LCD_WAIT_BUSYFLAG
+    if (rs)                                           // Reading the busy flag itself never has to wait
       lcd_waitbusy();
-      if (PrevCmdInvolvedAddressCounter)
-        {
-          Delay_us(5);
-          PrevCmdInvolvedAddressCounter=0;
-        }
     #endif
 
     if (rs)
       {
         lcd_rs_port_high();                             // RS=1: Read Data
-        #if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
+        #if LCD_WAIT_BUSYFLAG
         PrevCmdInvolvedAddressCounter=1;
         #endif
       }
@@ -366,53 +439,46 @@ static uint8_t lcd_read(uint8_t rs)
     
     lcd_rw_port_low();
 
-    #if (WAIT_MODE==0 || RW_LINE_IMPLEMENTED==0)
+    #if LCD_WAIT_DELAY
     if (rs)
-      Delay_us(40);
-    else Delay_us(1);
+      lcd_delay(data,rs);
     #endif
     return data;
   }
 
 uint8_t lcd_getc()
   {
+    #if LCD_ASYNC==1
+    lcd_queue_wait();                                 // Bus has to be free before reading
+    #endif
+    #if LCD_BUFFER==1
+    uint8_t c=lcd_read(1);
+    lcd_address++;                                    // Reading moves the address counter as well
+    if (lcd_address==0x28)
+      lcd_address=0x40;
+    else if (lcd_address==0x68)
+      lcd_address=0;
+    return c;
+    #else
     return lcd_read(1);
+    #endif
   }
 
 #endif
 
 /*************************************************************************
-Low-level function to write byte to LCD controller
+Low-level function to put a byte on the bus, without any waiting
 Input:    data   byte to write to LCD
           rs     1: write data
                  0: write instruction
 Returns:  none
 *************************************************************************/
-static void lcd_write(uint8_t data,uint8_t rs)
+static void lcd_write_bus(uint8_t data,uint8_t rs)
   {
-    #if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
-      lcd_waitbusy();
-      if (PrevCmdInvolvedAddressCounter)
-        {
-          Delay_us(5);
-          PrevCmdInvolvedAddressCounter=0;
-        }
-    #endif
-
     if (rs)
-      {
-        lcd_rs_port_high();                            // RS=1: Write Character
-        #if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
-        PrevCmdInvolvedAddressCounter=1;
-        #endif
-      }
+      lcd_rs_port_high();                              // RS=1: Write Character
     else
-      {
-        lcd_rs_port_low();                          // RS=0: Write Command
-        #if (WAIT_MODE==1 && RW_LINE_IMPLEMENTED==1)
-        PrevCmdInvolvedAddressCounter=0;
-        #endif
-      }
+      lcd_rs_port_low();                            // RS=0: Write Command
 
     #if LCD_BITS==4
       lcd_db7_port_set(data&_BV(7));                  //Output High Nibble
@@ -466,14 +532,168 @@ static void lcd_write(uint8_t data,uint8_t rs)
       lcd_db1_port_high();
       lcd_db0_port_high();
     #endif
+  }
+
+/*************************************************************************
+Low-level function to write byte to LCD controller
+Input:    data   byte to write to LCD
+          rs     1: write data
+                 0: write instruction
+Returns:  none
+*************************************************************************/
+static void lcd_write(uint8_t data,uint8_t rs)
+  {
+    PROFILE_BEGIN(PROFILE_LCD_WRITE);
+
+    #if LCD_WAIT_BUSYFLAG
+      lcd_waitbusy();
+      PrevCmdInvolvedAddressCounter=rs;
+    #endif
+
+    lcd_write_bus(data,rs);
+
+    #if LCD_WAIT_DELAY
+      lcd_delay(data,rs);
+    #endif
+
+    PROFILE_END(PROFILE_LCD_WRITE);
+  }
+
+#if LCD_ASYNC==1
+/*************************************************************************
+Write queue, drained by the timer 2 compare interrupt
+One byte is sent every LCD_ASYNC_TICK_US, when the display is not busy
+*************************************************************************/
+#define LCD_ASYNC_TOP      ((F_CPU/8/1000000)*LCD_ASYNC_TICK_US-1)
+#define LCD_ASYNC_HOLD     (1640/LCD_ASYNC_TICK_US)   // Ticks to wait after clrscr or home
+#define LCD_ASYNC_BUSYMAX  (2000/LCD_ASYNC_TICK_US)   // Busy ticks before the busy flag is considered broken
+
+static volatile uint8_t lcd_queue_data[LCD_QUEUE_SIZE];
+static volatile uint8_t lcd_queue_rs[LCD_QUEUE_SIZE];
+static volatile uint8_t lcd_queue_head=0;             // Next free entry
+static volatile uint8_t lcd_queue_tail=0;             // Next entry to send
+static volatile uint8_t lcd_queue_hold=0;             // Ticks to wait before the next byte
+static unsigned char lcd_queue_enabled=0;             // Bytes are queued instead of written right away
+#if LCD_WAIT_BUSYFLAG && (WAIT_MODE==2)
+static uint8_t lcd_queue_busyticks=0;                 // Ticks in a row the display was busy
+#endif
+
+ISR(TIMER2_COMPA_vect)
+  {
+    if (lcd_queue_tail==lcd_queue_head)               // Nothing left, stop the interrupt
+      {
+        TIMSK2&=~_BV(OCIE2A);
+        return;
+      }
+
+    if (lcd_queue_hold)
+      {
+        lcd_queue_hold--;
+        return;
+      }
+
+    #if LCD_WAIT_BUSYFLAG
+    #if (WAIT_MODE==2)
+    if (!BusyFlagFailed)
+    #endif
+      {
+        if (lcd_read(0) & (1<<LCD_BUSY))              // Try again on the next tick
+          {
+            #if (WAIT_MODE==2)
+            if (++lcd_queue_busyticks>=LCD_ASYNC_BUSYMAX)
+              BusyFlagFailed=1;
+            #endif
+            return;
+          }
+        #if (WAIT_MODE==2)
+        lcd_queue_busyticks=0;
+        #endif
+      }
+    #endif
+
+    uint8_t data=lcd_queue_data[lcd_queue_tail];
+    uint8_t rs=lcd_queue_rs[lcd_queue_tail];
+    lcd_queue_tail=(lcd_queue_tail+1)&(LCD_QUEUE_SIZE-1);
+
+    PROFILE_BEGIN(PROFILE_LCD_QUEUE);
+    lcd_write_bus(data,rs);
+    PROFILE_END(PROFILE_LCD_QUEUE);
+
+    #if LCD_WAIT_DELAY
+    #if (WAIT_MODE==2)
+    if (BusyFlagFailed)
+    #endif
+      if (!rs && data<=((1<<LCD_CLR) | (1<<LCD_HOME))) // Every other byte is done within one tick
+        lcd_queue_hold=LCD_ASYNC_HOLD;
+    #endif
+  }
+
+/*************************************************************************
+Put a byte in the write queue, waits while the queue is full
+Input:    data   byte to write to LCD
+          rs     1: write data
+                 0: write instruction
+Returns:  none
+*************************************************************************/
+static void lcd_queue_put(uint8_t data,uint8_t rs)
+  {
+    uint8_t next=(lcd_queue_head+1)&(LCD_QUEUE_SIZE-1);
 
-    #if (WAIT_MODE==0 || RW_LINE_IMPLEMENTED==0)
-      if (!rs && data<=((1<<LCD_CLR) | (1<<LCD_HOME))) // Is command clrscr or home?
-        Delay_us(1640);
-      else Delay_us(40);
+    while (next==lcd_queue_tail);                     // Wait for the interrupt to make room
+
+    lcd_queue_data[lcd_queue_head]=data;
+    lcd_queue_rs[lcd_queue_head]=rs;
+    lcd_queue_head=next;
+    TIMSK2|=_BV(OCIE2A);
+  }
+
+/*************************************************************************
+Wait until every queued byte is sent to the display
+Input:    none
+Returns:  none
+*************************************************************************/
+void lcd_queue_wait()
+  {
+    if (lcd_queue_enabled)
+      while (TIMSK2 & _BV(OCIE2A));
+  }
+#endif
+
+/*************************************************************************
+Send a byte to the LCD controller, queued in asynchronous mode
+Input:    data   byte to write to LCD
+          rs     1: write data
+                 0: write instruction
+Returns:  none
+*************************************************************************/
+static void lcd_send(uint8_t data,uint8_t rs)
+  {
+    #if LCD_ASYNC==1
+    if (lcd_queue_enabled)
+      {
+        lcd_queue_put(data,rs);
+        return;
+      }
     #endif
+    lcd_write(data,rs);
   }
 
+#if LCD_BUFFER==1
+/*************************************************************************
+Find the cell of a DDRAM address in a frame buffer
+Input:    buffer   lcd_buffer or lcd_glass
+          pos      DDRAM address
+Returns:  pointer to the cell, 0 if the address is outside the buffer
+*************************************************************************/
+static char *lcd_buffer_cell(char buffer[LCD_BUFFER_LINES][LCD_BUFFER_COLUMNS],uint8_t pos)
+  {
+    for (uint8_t i=0;i<LCD_BUFFER_LINES;i++)
+      if (pos>=lcd_line_address[i] && pos<lcd_line_address[i]+LCD_BUFFER_COLUMNS)
+        return &buffer[i][pos-lcd_line_address[i]];
+    return 0;
+  }
+#endif
+
 /*************************************************************************
 Send LCD controller instruction command
 Input:   instruction to send to LCD controller, see HD44780 data sheet
@@ -481,7 +701,7 @@ Returns: none
 *************************************************************************/
 void lcd_command(uint8_t cmd)
   {
-    lcd_write(cmd,0);
+    lcd_send(cmd,0);
   }
 
 /*************************************************************************
@@ -492,6 +712,9 @@ Returns:  none
 void lcd_goto(uint8_t pos)
   {
     lcd_command((1<<LCD_DDRAM)+pos);
+    #if LCD_BUFFER==1
+    lcd_address=pos;
+    #endif
   }
 
 
@@ -503,6 +726,12 @@ Returns:  none
 void lcd_clrscr()
   {
     lcd_command(1<<LCD_CLR);
+    #if LCD_BUFFER==1
+    lcd_address=0;
+    for (uint8_t i=0;i<LCD_BUFFER_LINES;i++)
+      for (uint8_t j=0;j<LCD_BUFFER_COLUMNS;j++)
+        lcd_glass[i][j]=' ';
+    #endif
   }
 
 
@@ -514,6 +743,9 @@ Returns:  none
 void lcd_home()
   {
     lcd_command(1<<LCD_HOME);
+    #if LCD_BUFFER==1
+    lcd_address=0;
+    #endif
   }
 
 
@@ -524,7 +756,18 @@ Returns:  none
 *************************************************************************/
 void lcd_putc(char c)
   {
-    lcd_write(c,1);
+    lcd_send(c,1);
+    #if LCD_BUFFER==1
+    char *cell=lcd_buffer_cell(lcd_glass,lcd_address);
+
+    if (cell)                                         // Keep track of what is on the display
+      *cell=c;
+    lcd_address++;
+    if (lcd_address==0x28)                            // Address counter skips the gap between the lines
+      lcd_address=0x40;
+    else if (lcd_address==0x68)
+      lcd_address=0;
+    #endif
   }
 
 
@@ -556,12 +799,115 @@ void lcd_puts_P(const char *progmem_s)
   }
 
 /*************************************************************************
-Initialize display
-Input:    none
+Define a custom character in CGRAM, shown as LCD_GLYPH(n)
+Characters already on the display change along, nothing is redrawn
+Input:    n              custom character, 0-7
+          progmem_rows   LCD_GLYPH_ROWS rows in flash, the lower 5 bits are the dots
 Returns:  none
 *************************************************************************/
-void lcd_init()
+void lcd_glyph_P(uint8_t n, const uint8_t *progmem_rows)
+  {
+    lcd_command((1<<LCD_CGRAM)+((n&7)<<3));
+    for (uint8_t i=0;i<LCD_GLYPH_ROWS;i++)
+      lcd_send(pgm_read_byte(progmem_rows++),1);
+    #if LCD_BUFFER==1
+    lcd_goto(lcd_address);                            // Back to DDRAM, where the display cursor was
+    #else
+    lcd_goto(0);
+    #endif
+  }
+
+/*************************************************************************
+Format signed fixed-point number right-aligned in a field
+Replaces sprintf so vfprintf is not linked in
+Input:    buf at least LCD_NUMBER_SIZE characters
+          value number in units of 10^-decimals, e.g. 235 with 1 decimal is 23.5
+          decimals digits after the decimal point
+          width minimum field width, limited to LCD_NUMBER_SIZE-1
+          pad character to fill the field with, '0' goes after the sign
+Returns:  none
+*************************************************************************/
+static void lcd_format_number(char *buf, int16_t value, uint8_t decimals, uint8_t width, char pad)
+  {
+    char digits[LCD_NUMBER_SIZE];
+    uint8_t n=0;
+    uint16_t magnitude=(value<0) ? -(uint16_t)value : (uint16_t)value;
+
+    do                                                // Digits come out reversed
+      {
+        digits[n++]='0'+magnitude%10;
+        magnitude/=10;
+        if (n==decimals)
+          digits[n++]='.';
+      }
+    while (magnitude || n<=decimals+(decimals>0));    // Keep a leading zero before the point
+
+    if (width>LCD_NUMBER_SIZE-1)
+      width=LCD_NUMBER_SIZE-1;
+
+    uint8_t length=n+(value<0);
+    uint8_t i=0;
+
+    if (value<0 && pad=='0')
+      buf[i++]='-';
+    for (;length<width;length++)
+      buf[i++]=pad;
+    if (value<0 && pad!='0')
+      buf[i++]='-';
+    while (n)
+      buf[i++]=digits[--n];
+    buf[i]=0;
+  }
+
+
+/*************************************************************************
+Display signed integer
+Input:    value number to be displayed
+          width minimum field width, 0 for no padding
+          pad character to fill the field with
+Returns:  none
+*************************************************************************/
+void lcd_putint(int16_t value, uint8_t width, char pad)
   {
+    lcd_putfixed(value,0,width,pad);
+  }
+
+
+/*************************************************************************
+Display signed fixed-point number, e.g. DHT22 tenths
+Input:    value number in units of 10^-decimals
+          decimals digits after the decimal point
+          width minimum field width, 0 for no padding
+          pad character to fill the field with
+Returns:  none
+*************************************************************************/
+void lcd_putfixed(int16_t value, uint8_t decimals, uint8_t width, char pad)
+  {
+    char buf[LCD_NUMBER_SIZE];
+
+    lcd_format_number(buf,value,decimals,width,pad);
+    lcd_puts(buf);
+  }
+
+/*************************************************************************
+Initialize display, lcd_init() and lcd_restart() differ in the waits only
+the power-on of the display needs
+Input:    warm 1 when the display kept its power, 0 after power-on
+Returns:  none
+*************************************************************************/
+static void lcd_start(uint8_t warm)
+  {
+    #if LCD_ASYNC==1
+    lcd_queue_wait();                                 // Initialization writes directly
+    lcd_queue_enabled=0;
+    #endif
+    #if (WAIT_MODE==2)
+    BusyFlagFailed=0;                                 // Give the busy flag a new chance
+    #if LCD_ASYNC==1
+    lcd_queue_busyticks=0;
+    #endif
+    #endif
+
     //Set All Pins as Output
     lcd_e_ddr_high();
     lcd_rs_ddr_high();
@@ -598,8 +944,11 @@ void lcd_init()
       lcd_db0_port_high();
     #endif
 
-    //Startup Delay
-    Delay_ms(DELAY_RESET);
+    //Startup Delay, a display that kept its power is ready
+    if (!warm)
+      {
+        Delay_ms(DELAY_RESET);
+      }
 
     //Initialize Display
     lcd_db7_port_low();
@@ -609,7 +958,16 @@ void lcd_init()
     Delay_ns(500);
     lcd_e_port_low();
 
-    Delay_us(4100);
+    //The three function sets also bring a powered display back in step,
+    //should the reset have come between the two nibbles of a byte
+    if (warm)
+      {
+        Delay_us(100);
+      }
+    else
+      {
+        Delay_us(4100);
+      }
 
     lcd_e_port_high();
     Delay_ns(500);
@@ -696,14 +1054,61 @@ void lcd_init()
     //Display Off
     lcd_command(_BV(LCD_DISPLAYMODE));
 
-    //Display Clear
-    lcd_clrscr();
+    //Display Clear, after a warm start the next flush overwrites everything instead
+    if (!warm)
+      lcd_clrscr();
+    else
+      lcd_goto(0);                                    // The address counter is unknown
+    #if LCD_BUFFER==1
+      lcd_buffer_clear();
+      if (warm)
+        lcd_buffer_invalidate();
+    #endif
 
     //Entry Mode Set
     lcd_command(_BV(LCD_ENTRY_MODE) | _BV(LCD_ENTRY_INC));
 
+    #if LCD_GLYPHS>0
+    //Custom Characters, only once as CGRAM keeps them while powered
+    if (!warm)
+      for (uint8_t i=0;i<LCD_GLYPHS;i++)
+        lcd_glyph_P(i,lcd_glyphs[i]);
+    #endif
+
     //Display On
     lcd_command(_BV(LCD_DISPLAYMODE) | _BV(LCD_DISPLAYMODE_ON));
+
+    #if LCD_ASYNC==1
+      //From now on bytes are queued and sent by timer 2
+      TCCR2A=_BV(WGM21);                              // CTC mode with OCR2A as top
+      TCCR2B=_BV(CS21);                               // Prescaler 8
+      OCR2A=LCD_ASYNC_TOP;
+      lcd_queue_head=lcd_queue_tail=0;
+      lcd_queue_hold=0;
+      lcd_queue_enabled=1;
+    #endif
+  }
+
+/*************************************************************************
+Initialize display after power-on
+Input:    none
+Returns:  none
+*************************************************************************/
+void lcd_init()
+  {
+    lcd_start(0);
+  }
+
+/*************************************************************************
+Initialize display after a reset of the MCU alone, like a watchdog reset.
+Skips the power-on waits, the clear and the custom characters, which the
+display kept: takes well under a millisecond instead of about 20
+Input:    none
+Returns:  none
+*************************************************************************/
+void lcd_restart()
+  {
+    lcd_start(1);
   }
 
 #if (LCD_DISPLAYS>1)
@@ -714,3 +1119,145 @@ void lcd_use_display(int ADisplay)
   }
 #endif
 
+#if (WAIT_MODE==2)
+/*************************************************************************
+Check if the busy flag timed out and fixed delays are used instead
+Input:    none
+Returns:  1 if delays are used, 0 if the busy flag works
+*************************************************************************/
+uint8_t lcd_busy_fallback()
+  {
+    return BusyFlagFailed;
+  }
+#endif
+
+#if LCD_BUFFER==1
+/*************************************************************************
+Clear the frame buffer to spaces and put its cursor at the start
+Input:    none
+Returns:  none
+*************************************************************************/
+void lcd_buffer_clear()
+  {
+    for (uint8_t i=0;i<LCD_BUFFER_LINES;i++)
+      for (uint8_t j=0;j<LCD_BUFFER_COLUMNS;j++)
+        lcd_buffer[i][j]=' ';
+    lcd_buffer_pos=0;
+  }
+
+
+/*************************************************************************
+Set frame buffer cursor to specified position
+Input:    pos position, same DDRAM addressing as lcd_goto
+Returns:  none
+*************************************************************************/
+void lcd_buffer_goto(uint8_t pos)
+  {
+    lcd_buffer_pos=pos;
+  }
+
+
+/*************************************************************************
+Put character in the frame buffer
+Input:    character to be displayed on the next flush
+Returns:  none
+*************************************************************************/
+void lcd_buffer_putc(char c)
+  {
+    char *cell=lcd_buffer_cell(lcd_buffer,lcd_buffer_pos);
+
+    if (cell)                                         // Characters past the end of a line are dropped
+      *cell=c;
+    lcd_buffer_pos++;
+  }
+
+
+/*************************************************************************
+Put string in the frame buffer
+Input:    string to be displayed on the next flush
+Returns:  none
+*************************************************************************/
+void lcd_buffer_puts(const char *s)
+  {
+    register char c;
+
+    while ((c=*s++))
+      lcd_buffer_putc(c);
+  }
+
+
+/*************************************************************************
+Put string from flash in the frame buffer
+Input:    string to be displayed on the next flush
+Returns:  none
+*************************************************************************/
+void lcd_buffer_puts_P(const char *progmem_s)
+  {
+    register char c;
+
+    while ((c=pgm_read_byte(progmem_s++)))
+      lcd_buffer_putc(c);
+  }
+
+
+/*************************************************************************
+Put signed integer in the frame buffer
+Input:    value number to be displayed on the next flush
+          width minimum field width, 0 for no padding
+          pad character to fill the field with
+Returns:  none
+*************************************************************************/
+void lcd_buffer_putint(int16_t value, uint8_t width, char pad)
+  {
+    lcd_buffer_putfixed(value,0,width,pad);
+  }
+
+
+/*************************************************************************
+Put signed fixed-point number in the frame buffer
+Input:    value number in units of 10^-decimals
+          decimals digits after the decimal point
+          width minimum field width, 0 for no padding
+          pad character to fill the field with
+Returns:  none
+*************************************************************************/
+void lcd_buffer_putfixed(int16_t value, uint8_t decimals, uint8_t width, char pad)
+  {
+    char buf[LCD_NUMBER_SIZE];
+
+    lcd_format_number(buf,value,decimals,width,pad);
+    lcd_buffer_puts(buf);
+  }
+
+
+/*************************************************************************
+Send the characters that differ from the display
+Adjacent changed characters share a single DDRAM address set
+Input:    none
+Returns:  none
+*************************************************************************/
+void lcd_buffer_flush()
+  {
+    for (uint8_t i=0;i<LCD_BUFFER_LINES;i++)
+      for (uint8_t j=0;j<LCD_BUFFER_COLUMNS;j++)
+        if (lcd_buffer[i][j]!=lcd_glass[i][j])
+          {
+            if (lcd_address!=lcd_line_address[i]+j)   // Only move when the display cursor is elsewhere
+              lcd_goto(lcd_line_address[i]+j);
+            lcd_putc(lcd_buffer[i][j]);
+          }
+  }
+
+
+/*************************************************************************
+Forget what is on the display, the next flush sends every character
+Input:    none
+Returns:  none
+*************************************************************************/
+void lcd_buffer_invalidate()
+  {
+    for (uint8_t i=0;i<LCD_BUFFER_LINES;i++)
+      for (uint8_t j=0;j<LCD_BUFFER_COLUMNS;j++)
+        lcd_glass[i][j]=~lcd_buffer[i][j];
+  }
+#endif
\ No newline at end of file
@@ -38,8 +38,19 @@ Version:   1.11
 
 #define LCD_BUSY                7    // DB7: LCD is busy
 
+#define LCD_NUMBER_SIZE         17   // Longest formatted number including terminator
+
+#define LCD_GLYPH_ROWS          8    // Rows of a 5x8 custom character
+#define LCD_GLYPH(n)            ((char)(8+(n)))  // Character of custom character n, codes 8-15 show CGRAM 0-7
+                                                 // so a glyph can be part of a string
+
+#if LCD_GLYPHS>0
+extern const uint8_t lcd_glyphs[LCD_GLYPHS][LCD_GLYPH_ROWS];   // Uploaded by lcd_init(), in flash
+#endif
+
 
 void lcd_init();
+void lcd_restart();
 void lcd_command(uint8_t cmd);
 
 void lcd_clrscr();
@@ -50,12 +61,35 @@ void lcd_goto(uint8_t pos);
 uint8_t lcd_getc();
 #endif
 
+#if (WAIT_MODE==2)
+uint8_t lcd_busy_fallback();
+#endif
+
 void lcd_putc(char c);
 void lcd_puts(const char *s);
 void lcd_puts_P(const char *progmem_s);
+void lcd_glyph_P(uint8_t n, const uint8_t *progmem_rows);
+void lcd_putint(int16_t value, uint8_t width, char pad);
+void lcd_putfixed(int16_t value, uint8_t decimals, uint8_t width, char pad);
 #if (LCD_DISPLAYS>1)
 void lcd_use_display(int ADisplay);
 #endif
 
+#if LCD_ASYNC==1
+void lcd_queue_wait();
+#endif
+
+#if LCD_BUFFER==1
+void lcd_buffer_clear();
+void lcd_buffer_goto(uint8_t pos);
+void lcd_buffer_putc(char c);
+void lcd_buffer_puts(const char *s);
+void lcd_buffer_puts_P(const char *progmem_s);
+void lcd_buffer_putint(int16_t value, uint8_t width, char pad);
+void lcd_buffer_putfixed(int16_t value, uint8_t decimals, uint8_t width, char pad);
+void lcd_buffer_flush();
+void lcd_buffer_invalidate();
+#endif
+
 #endif
 
@@ -1,14 +1,27 @@
 #ifndef HD44780_SETTINGS_H
 #define HD44780_SETTINGS_H
 
-#define F_CPU                    16000000     // Set Clock Frequency
+#include "pins.h"
+
 
 #define USE_ADELAY_LIBRARY       0           // Set to 1 to use my ADELAY library, 0 to use internal delay functions
 #define LCD_BITS                 4           // 4 for 4 Bit I/O Mode, 8 for 8 Bit I/O Mode
-#define RW_LINE_IMPLEMENTED      0           // 0 for no RW line (RW on LCD tied to ground), 1 for RW line present
-#define WAIT_MODE                0           // 0=Use Delay Method (Faster if running <10Mhz)
+#define RW_LINE_IMPLEMENTED      1           // 0 for no RW line (RW on LCD tied to ground), 1 for RW line present
+                                             // RW of the display goes to BOARD_LCD_RW of pins.h, A4 (PC4) on the
+                                             // Nano, instead of to ground: rewire it or set 0 and WAIT_MODE 0
+#define WAIT_MODE                2           // 0=Use Delay Method (Faster if running <10Mhz)
                                              // 1=Use Check Busy Flag (Faster if running >10Mhz) ***Requires RW Line***
+                                             // 2=Use Check Busy Flag, fall back to Delay Method when the busy flag
+                                             //   times out (RW line broken or not wired) ***Requires RW Line***
 #define DELAY_RESET              15          // in mS
+#define LCD_BUFFER               1           // 1 to enable the lcd_buffer_* functions, a frame buffer of which
+                                             // lcd_buffer_flush() only sends the characters that changed
+#define LCD_BUFFER_COLUMNS       16          // Characters per line of the frame buffer (ONLY used if LCD_BUFFER=1)
+#define LCD_ASYNC                1           // 1 to queue every byte and send it from the timer 2 compare interrupt
+#define LCD_ASYNC_TICK_US        40          // Time between two queued bytes (ONLY used if LCD_ASYNC=1)
+#define LCD_QUEUE_SIZE           64          // Bytes in the write queue, power of 2 (ONLY used if LCD_ASYNC=1)
+#define LCD_GLYPHS               8           // Custom characters lcd_init() uploads to CGRAM from the lcd_glyphs[] table
+                                             // the application defines in flash, 0 for none, at most 8
 
 #if (LCD_BITS==8)                            // If using 8 bit mode, you must configure DB0-DB7
   #define LCD_DB0_PORT           PORTC
@@ -20,20 +33,21 @@
   #define LCD_DB3_PORT           PORTC
   #define LCD_DB3_PIN            3
 #endif
-#define LCD_DB4_PORT             PORTC       // If using 4 bit omde, yo umust configure DB4-DB7
-#define LCD_DB4_PIN              0
-#define LCD_DB5_PORT             PORTC
-#define LCD_DB5_PIN              1
-#define LCD_DB6_PORT             PORTC
-#define LCD_DB6_PIN              2
-#define LCD_DB7_PORT             PORTC
-#define LCD_DB7_PIN              3
+                                             // The pins of display 1 are set in pins.h
+#define LCD_DB4_PORT             PIN_PORTREG(BOARD_LCD_DB4)  // If using 4 bit omde, yo umust configure DB4-DB7
+#define LCD_DB4_PIN              PIN_BIT(BOARD_LCD_DB4)
+#define LCD_DB5_PORT             PIN_PORTREG(BOARD_LCD_DB5)
+#define LCD_DB5_PIN              PIN_BIT(BOARD_LCD_DB5)
+#define LCD_DB6_PORT             PIN_PORTREG(BOARD_LCD_DB6)
+#define LCD_DB6_PIN              PIN_BIT(BOARD_LCD_DB6)
+#define LCD_DB7_PORT             PIN_PORTREG(BOARD_LCD_DB7)
+#define LCD_DB7_PIN              PIN_BIT(BOARD_LCD_DB7)
 
-#define LCD_RS_PORT              PORTD       // Port for RS line
-#define LCD_RS_PIN               7           // Pin for RS line
+#define LCD_RS_PORT              PIN_PORTREG(BOARD_LCD_RS)   // Port for RS line
+#define LCD_RS_PIN               PIN_BIT(BOARD_LCD_RS)       // Pin for RS line
 
-#define LCD_RW_PORT              PORTC       // Port for RW line (ONLY used if RW_LINE_IMPLEMENTED=1)
-#define LCD_RW_PIN               6           // Pin for RW line (ONLY used if RW_LINE_IMPLEMENTED=1)
+#define LCD_RW_PORT              PIN_PORTREG(BOARD_LCD_RW)   // Port for RW line (ONLY used if RW_LINE_IMPLEMENTED=1)
+#define LCD_RW_PIN               PIN_BIT(BOARD_LCD_RW)       // Pin for RW line (ONLY used if RW_LINE_IMPLEMENTED=1)
 
 #define LCD_DISPLAYS             1           // Up to 4 LCD displays can be used at one time
                                              // All pins are shared between displays except for the E
@@ -41,8 +55,8 @@
 
                                              // Display 1 Settings - if you only have 1 display, YOU MUST SET THESE
 #define LCD_DISPLAY_LINES        2           // Number of Lines, Only Used for Set I/O Mode Command
-#define LCD_E_PORT               PORTB       // Port for E line
-#define LCD_E_PIN                0           // Pin for E line
+#define LCD_E_PORT               PIN_PORTREG(BOARD_LCD_E)    // Port for E line
+#define LCD_E_PIN                PIN_BIT(BOARD_LCD_E)        // Pin for E line
 
 #if (LCD_DISPLAYS>=2)                        // If you have 2 displays, set these and change LCD_DISPLAYS=2
   #define LCD_DISPLAY2_LINES     2           // Number of Lines, Only Used for Set I/O Mode Command
@@ -0,0 +1,435 @@
+/**
+ * Title:   	Reading history
+ *
+ * See history.h for the layout of the ring buffer and the windows.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "history.h"
+#include "sched.h"
+#include "restart.h"
+
+#define HISTORY_HOUR_BUCKETS (HISTORY_HOUR_SAMPLES / HISTORY_HOUR_BUCKET)
+#define HISTORY_DAY_BUCKETS (HISTORY_DAY_SAMPLES / HISTORY_DAY_BUCKET)
+#define HISTORY_QUEUESIZE (HISTORY_HOUR_BUCKETS + HISTORY_DAY_BUCKETS)
+
+#if (HISTORY_HOUR_SAMPLES % HISTORY_HOUR_BUCKET) != 0 || (HISTORY_DAY_SAMPLES % HISTORY_DAY_BUCKET) != 0
+#error "history window lengths have to be a multiple of their bucket size"
+#endif
+
+#if HISTORY_SIZE > 255 || HISTORY_HOUR_SAMPLES > HISTORY_SIZE || HISTORY_DAY_SAMPLES > HISTORY_SIZE
+#error "history windows can not be longer than the ring buffer, which holds at most 255 samples"
+#endif
+
+typedef struct {
+	uint8_t samples;			// window length in samples
+	uint8_t bucket;				// samples per minimum/maximum bucket
+	uint8_t offset;				// first entry of the window in the queue pools
+} history_config_t;
+
+typedef struct {
+	int16_t value;				// extreme of a completed bucket
+	uint8_t bucket;				// sequence number of that bucket
+} history_entry_t;
+
+typedef struct {
+	uint8_t head;				// oldest entry, the extreme of the window
+	uint8_t length;
+} history_queue_t;
+
+typedef struct {
+	int32_t sum;				// sum of the samples in the window
+	int16_t oldest;				// value of the oldest sample in the window
+	int16_t bucketmin;			// extremes of the bucket that is being filled
+	int16_t bucketmax;
+	history_queue_t min;		// bucket minimums, rising from head to tail
+	history_queue_t max;		// bucket maximums, falling from head to tail
+} history_stats_t;
+
+typedef struct {
+	uint8_t count;				// samples in the window
+	uint8_t start;				// ring position of the oldest sample in the window
+	uint8_t fill;				// samples in the bucket that is being filled
+	uint8_t bucket;				// sequence number of the bucket that is being filled
+	history_stats_t stats[HISTORY_CHANNELS];
+} history_window_t;
+
+static const history_config_t history_config[HISTORY_WINDOWS] = {
+	{HISTORY_HOUR_SAMPLES, HISTORY_HOUR_BUCKET, 0},
+	{HISTORY_DAY_SAMPLES, HISTORY_DAY_BUCKET, HISTORY_HOUR_BUCKETS}
+};
+
+// All of the history is kept over a warm restart, see restart.h
+static int8_t history_deltas[HISTORY_SIZE][HISTORY_CHANNELS] RESTART_NOINIT;
+static uint8_t history_head RESTART_NOINIT;			// ring position the next sample goes to
+static uint8_t history_samples RESTART_NOINIT;		// samples in the ring
+static int16_t history_newest[HISTORY_CHANNELS] RESTART_NOINIT;
+static uint32_t history_time RESTART_NOINIT;		// millis of the newest sample
+static uint16_t history_stored RESTART_NOINIT;		// samples stored since the start, wraps around
+
+static int32_t history_periodsum[HISTORY_CHANNELS] RESTART_NOINIT;	// readings of the sample that is being averaged
+static uint16_t history_periodcount RESTART_NOINIT;
+static uint32_t history_periodstart RESTART_NOINIT;
+
+static history_window_t history_windows[HISTORY_WINDOWS] RESTART_NOINIT;
+static history_entry_t history_minpool[HISTORY_CHANNELS][HISTORY_QUEUESIZE] RESTART_NOINIT;
+static history_entry_t history_maxpool[HISTORY_CHANNELS][HISTORY_QUEUESIZE] RESTART_NOINIT;
+
+/**
+ * Function: Adds the extreme of a completed bucket to a monotonic queue. Entries that can
+ * no longer be the extreme while the new one is in the window are dropped from the tail.
+ * Arguments:
+ * 		1. Entries of the queue.
+ * 		2. Capacity of the queue, the amount of buckets in the window.
+ * 		3. Queue.
+ * 		4. Extreme of the bucket.
+ * 		5. Sequence number of the bucket.
+ * 		6. 1 for a maximum queue, 0 for a minimum queue.
+ * Returns: None.
+ */
+static void history_queue_push(history_entry_t *pool, uint8_t size, history_queue_t *queue, int16_t value, uint8_t bucket, uint8_t ismax) {
+	while (queue->length) {
+		int16_t tail = pool[(queue->head + queue->length - 1) % size].value;
+		if (ismax ? tail > value : tail < value) {
+			break;
+		}
+		queue->length--;
+	}
+
+	history_entry_t *entry = &pool[(queue->head + queue->length) % size];
+	entry->value = value;
+	entry->bucket = bucket;
+	queue->length++;
+}
+
+/**
+ * Function: Drops the entries of buckets that left the window from the head of a queue.
+ * Arguments:
+ * 		1. Entries of the queue.
+ * 		2. Capacity of the queue, the amount of buckets in the window.
+ * 		3. Queue.
+ * 		4. Sequence number of the bucket that is being filled.
+ * Returns: None.
+ */
+static void history_queue_expire(history_entry_t *pool, uint8_t size, history_queue_t *queue, uint8_t bucket) {
+	while (queue->length && (uint8_t)(bucket - pool[queue->head].bucket) >= size) {
+		queue->head = (queue->head + 1) % size;
+		queue->length--;
+	}
+}
+
+/**
+ * Function: Moves a window one sample ahead. Has to run before the delta of the new sample is stored.
+ * Arguments:
+ * 		1. Window id.
+ * 		2. Ring position of the new sample.
+ * 		3. Values of the new sample, as stored.
+ * Returns: None.
+ */
+static void history_window_add(uint8_t id, uint8_t position, const int16_t values[HISTORY_CHANNELS]) {
+	const history_config_t *config = &history_config[id];
+	history_window_t *window = &history_windows[id];
+	uint8_t buckets = config->samples / config->bucket;
+	uint8_t next = (window->start + 1) % HISTORY_SIZE;
+
+	for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+		history_stats_t *stats = &window->stats[ch];
+		history_entry_t *minpool = &history_minpool[ch][config->offset];
+		history_entry_t *maxpool = &history_maxpool[ch][config->offset];
+
+		if (window->count == 0) {
+			stats->oldest = values[ch];
+		}
+		else if (window->count == config->samples) {  // The oldest sample leaves the window
+			stats->sum -= stats->oldest;
+			stats->oldest += history_deltas[next][ch];
+		}
+		stats->sum += values[ch];
+
+		if (window->fill == 0) {  // A new bucket starts, the oldest one is out of the window now
+			history_queue_expire(minpool, buckets, &stats->min, window->bucket);
+			history_queue_expire(maxpool, buckets, &stats->max, window->bucket);
+			stats->bucketmin = values[ch];
+			stats->bucketmax = values[ch];
+		}
+		else if (values[ch] < stats->bucketmin) {
+			stats->bucketmin = values[ch];
+		}
+		else if (values[ch] > stats->bucketmax) {
+			stats->bucketmax = values[ch];
+		}
+
+		if (window->fill + 1 == config->bucket) {
+			history_queue_push(minpool, buckets, &stats->min, stats->bucketmin, window->bucket, 0);
+			history_queue_push(maxpool, buckets, &stats->max, stats->bucketmax, window->bucket, 1);
+		}
+	}
+
+	if (window->count == 0) {
+		window->start = position;
+		window->count = 1;
+	}
+	else if (window->count == config->samples) {
+		window->start = next;
+	}
+	else {
+		window->count++;
+	}
+
+	if (++window->fill == config->bucket) {
+		window->fill = 0;
+		window->bucket++;
+	}
+}
+
+/**
+ * Function: Stores a sample in the ring buffer and moves all windows ahead.
+ * Arguments:
+ * 		1. Values of the sample.
+ * 		2. Millis the sample was taken.
+ * Returns: None.
+ */
+static void history_store(const int16_t values[HISTORY_CHANNELS], uint32_t time) {
+	int8_t deltas[HISTORY_CHANNELS];
+	int16_t stored[HISTORY_CHANNELS];
+
+	for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+		int16_t delta = (history_samples == 0) ? 0 : values[ch] - history_newest[ch];
+
+		if (delta > INT8_MAX) {  // Clamped, the next samples catch up with the reading
+			delta = INT8_MAX;
+		}
+		else if (delta < INT8_MIN) {
+			delta = INT8_MIN;
+		}
+
+		deltas[ch] = delta;
+		stored[ch] = (history_samples == 0) ? values[ch] : history_newest[ch] + delta;
+	}
+
+	for (uint8_t id = 0; id < HISTORY_WINDOWS; id++) {
+		history_window_add(id, history_head, stored);
+	}
+
+	for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+		history_deltas[history_head][ch] = deltas[ch];
+		history_newest[ch] = stored[ch];
+	}
+
+	history_head = (history_head + 1) % HISTORY_SIZE;
+	if (history_samples < HISTORY_SIZE) {
+		history_samples++;
+	}
+	history_time = time;
+	history_stored++;
+}
+
+/**
+ * Function: Empties the history.
+ * Argument: None.
+ * Returns: None.
+ */
+void history_init(void) {
+	memset(history_windows, 0, sizeof(history_windows));
+	memset(history_periodsum, 0, sizeof(history_periodsum));
+	history_head = 0;
+	history_samples = 0;
+	history_periodcount = 0;
+}
+
+/**
+ * Function: Adds a valid reading. The very first reading is stored right away, after that the
+ * readings are averaged and stored as a sample once every HISTORY_PERIOD_MS.
+ * Argument: Values of the reading, one per channel.
+ * Returns: None.
+ */
+void history_add(const int16_t values[HISTORY_CHANNELS]) {
+	uint32_t now = sched_millis();
+
+	if (history_samples == 0) {
+		history_store(values, now);
+		history_periodstart = now;
+		return;
+	}
+
+	for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+		history_periodsum[ch] += values[ch];
+	}
+	history_periodcount++;
+
+	if (now - history_periodstart >= HISTORY_PERIOD_MS) {
+		int16_t average[HISTORY_CHANNELS];
+
+		for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+			int32_t half = (history_periodsum[ch] < 0) ? -(history_periodcount / 2) : history_periodcount / 2;
+			average[ch] = (history_periodsum[ch] + half) / history_periodcount;
+			history_periodsum[ch] = 0;
+		}
+		history_periodcount = 0;
+		history_periodstart = now;
+
+		history_store(average, now);
+	}
+}
+
+/**
+ * Function: Stores a sample right away without averaging, used to put back a saved history.
+ * Argument: Values of the sample, one per channel.
+ * Returns: None.
+ */
+void history_load(const int16_t values[HISTORY_CHANNELS]) {
+	history_periodstart = sched_millis();
+	history_store(values, history_periodstart);
+}
+
+/**
+ * Function: Returns a counter that increases with every stored sample, to find out which samples are new.
+ * Argument: None.
+ * Returns: amount of stored samples, wraps around.
+ */
+uint16_t history_sequence(void) {
+	return history_stored;
+}
+
+/**
+ * Function: Returns the amount of samples in the history.
+ * Argument: None.
+ * Returns: samples, at most HISTORY_SIZE.
+ */
+uint8_t history_count(void) {
+	return history_samples;
+}
+
+/**
+ * Function: Reconstructs an older sample from the deltas, takes time according to its age.
+ * Arguments:
+ * 		1. Age in samples, 0 is the newest.
+ * 		2. Array that receives the values of the sample.
+ * 		3. Receives the millis the sample was taken, assuming samples were HISTORY_PERIOD_MS apart. May be NULL.
+ * Returns: 0 on success, -1 when the history does not reach back that far.
+ */
+int8_t history_get(uint8_t age, int16_t values[HISTORY_CHANNELS], uint32_t *time) {
+	if (age >= history_samples) {
+		return -1;
+	}
+
+	uint8_t position = (history_head + HISTORY_SIZE - 1) % HISTORY_SIZE;
+
+	for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+		values[ch] = history_newest[ch];
+	}
+	for (uint8_t i = 0; i < age; i++) {
+		for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+			values[ch] -= history_deltas[position][ch];
+		}
+		position = (position + HISTORY_SIZE - 1) % HISTORY_SIZE;
+	}
+
+	if (time) {
+		*time = history_time - (uint32_t)age * HISTORY_PERIOD_MS;
+	}
+	return 0;
+}
+
+/**
+ * Function: Averages the newest samples of a channel in groups, walking the deltas once.
+ * Arguments:
+ * 		1. Channel.
+ * 		2. Samples per group.
+ * 		3. Amount of groups.
+ * 		4. Array that receives the averages, oldest group first and the newest group last.
+ * Returns: amount of groups filled from the end of the array, less than asked while the history is short.
+ */
+uint8_t history_series(uint8_t channel, uint8_t span, uint8_t groups, int16_t *values) {
+	uint8_t position = (history_head + HISTORY_SIZE - 1) % HISTORY_SIZE;
+	uint8_t age = 0;
+	uint8_t filled = 0;
+	int16_t value = history_newest[channel];
+
+	while (filled < groups && age < history_samples) {
+		int32_t sum = 0;
+		uint8_t count = 0;
+
+		for (; count < span && age < history_samples; count++, age++) {
+			sum += value;
+			value -= history_deltas[position][channel];  // One sample older
+			position = (position + HISTORY_SIZE - 1) % HISTORY_SIZE;
+		}
+
+		int16_t half = (sum < 0) ? -(count / 2) : count / 2;
+		values[groups - 1 - filled] = (sum + half) / count;
+		filled++;
+	}
+	return filled;
+}
+
+/**
+ * Function: Returns the lowest sample of a window.
+ * Arguments:
+ * 		1. Channel.
+ * 		2. Window id.
+ * Returns: lowest value, 0 while the history is empty.
+ */
+int16_t history_min(uint8_t channel, uint8_t window) {
+	const history_window_t *w = &history_windows[window];
+	const history_stats_t *stats = &w->stats[channel];
+
+	if (w->count == 0) {
+		return 0;
+	}
+	if (stats->min.length == 0) {
+		return stats->bucketmin;
+	}
+
+	int16_t value = history_minpool[channel][history_config[window].offset + stats->min.head].value;
+	if (w->fill && stats->bucketmin < value) {
+		value = stats->bucketmin;
+	}
+	return value;
+}
+
+/**
+ * Function: Returns the highest sample of a window.
+ * Arguments:
+ * 		1. Channel.
+ * 		2. Window id.
+ * Returns: highest value, 0 while the history is empty.
+ */
+int16_t history_max(uint8_t channel, uint8_t window) {
+	const history_window_t *w = &history_windows[window];
+	const history_stats_t *stats = &w->stats[channel];
+
+	if (w->count == 0) {
+		return 0;
+	}
+	if (stats->max.length == 0) {
+		return stats->bucketmax;
+	}
+
+	int16_t value = history_maxpool[channel][history_config[window].offset + stats->max.head].value;
+	if (w->fill && stats->bucketmax > value) {
+		value = stats->bucketmax;
+	}
+	return value;
+}
+
+/**
+ * Function: Returns the rounded mean of the samples in a window.
+ * Arguments:
+ * 		1. Channel.
+ * 		2. Window id.
+ * Returns: mean value, 0 while the history is empty.
+ */
+int16_t history_mean(uint8_t channel, uint8_t window) {
+	const history_window_t *w = &history_windows[window];
+	int32_t sum = w->stats[channel].sum;
+
+	if (w->count == 0) {
+		return 0;
+	}
+
+	int32_t half = (sum < 0) ? -(w->count / 2) : w->count / 2;
+	return (sum + half) / w->count;
+}
@@ -0,0 +1,57 @@
+/**
+ * Title:   	Reading history
+ *
+ * Keeps the readings of the last 24 hours in a ring buffer in SRAM. Readings are
+ * averaged over HISTORY_PERIOD_MS and stored as one sample, every sample only keeps
+ * the 8 bit difference to the one before it. Jumps larger than a delta can hold are
+ * clamped, the stored series then catches up over the next samples.
+ *
+ * Every window keeps a running sum and its oldest value, so the mean is updated in
+ * constant time when a sample enters and another one leaves. Minimum and maximum are
+ * kept per bucket of samples in monotonic queues: adding a sample costs constant
+ * amortized time and reading them never rescans the buffer. Because of the buckets the
+ * minimum and maximum can cover up to one bucket less than the mean does.
+ */
+
+#ifndef HISTORY_H_
+#define HISTORY_H_
+
+#include <stdint.h>
+
+#include "sensor.h"
+
+//values stored per sample, a temperature and a humidity channel for every sensor
+#define HISTORY_CHANNELS (2 * SENSOR_COUNT)
+#define HISTORY_TEMPERATURE 0
+#define HISTORY_HUMIDITY 1
+#define HISTORY_CHANNEL(sensor, value) (2 * (sensor) + (value))
+
+//time a sample covers, readings within it are averaged
+#define HISTORY_PERIOD_MS 600000UL
+
+//samples in the ring buffer, 24 hours of 10 minutes, takes HISTORY_SIZE * HISTORY_CHANNELS bytes
+//lower it to fit more than two sensors
+#define HISTORY_SIZE 144
+
+//windows, the length has to be a multiple of the bucket size and at most HISTORY_SIZE
+#define HISTORY_WINDOWS 2
+#define HISTORY_HOUR 0
+#define HISTORY_HOUR_SAMPLES 6
+#define HISTORY_HOUR_BUCKET 1
+#define HISTORY_DAY 1
+#define HISTORY_DAY_SAMPLES HISTORY_SIZE
+#define HISTORY_DAY_BUCKET 6
+
+//functions
+extern void history_init(void);
+extern void history_add(const int16_t values[HISTORY_CHANNELS]);
+extern void history_load(const int16_t values[HISTORY_CHANNELS]);
+extern uint16_t history_sequence(void);
+extern uint8_t history_count(void);
+extern int8_t history_get(uint8_t age, int16_t values[HISTORY_CHANNELS], uint32_t *time);
+extern uint8_t history_series(uint8_t channel, uint8_t span, uint8_t groups, int16_t *values);
+extern int16_t history_min(uint8_t channel, uint8_t window);
+extern int16_t history_max(uint8_t channel, uint8_t window);
+extern int16_t history_mean(uint8_t channel, uint8_t window);
+
+#endif
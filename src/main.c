@@ -3,9 +3,9 @@
  * Author:  	Jaap Kanbier
  * 
  * Creation:	23 March 2019
- * Modified:	1 April 2019
+ * Modified:	14 October 2026
  * 
- * Version:		1.0
+ * Version:		1.25
  * 
  * Changelog:
  * 0.1      Created file, build basic DHT11 functionality
@@ -21,13 +21,38 @@
  * 0.11		Added filtering for unrealistic measurements (max delta 5 per measurement)
  * 0.12		Moved main loop lcd display logic to interupt flow to sync with animation
  * 1.0		Completed final documentation and succesfull test runs
+ * 1.1		Replaced busy-waiting in timer interupt by cooperative scheduler tasks
+ * 1.2		Animation frames are drawn in the LED matrix frame buffer, only changed rows are sent
+ * 1.3		Sensor is read asynchronously, edges are timestamped by the pin change interrupt
+ * 1.4		Sensor is sampled at a fixed rate instead of back-to-back
+ * 1.5		Screens are drawn in the LCD frame buffer, only changed characters are sent
+ * 1.6		LCD writes are queued and sent from a timer interupt
+ * 1.7		Warning sound is generated by timer 0 in hardware
+ * 1.8		Every warning type plays its own beep pattern, sensor failures included
+ * 1.9		Sprites and animations moved to flash, played by the animation engine
+ * 1.10		Numbers are formatted by the LCD driver, sprintf is no longer linked in
+ * 1.11		DHT22 readings are handled as integer tenths instead of floats
+ * 1.12		Readings are kept for 24 hours, history screens show the last 24 hours
+ * 1.13		Statistics and history are saved in EEPROM and restored at boot
+ * 1.14		Readings and alarm changes are streamed over the UART
+ * 1.15		Limits and timing are set over the UART and kept in EEPROM, alarms end with hysteresis
+ * 1.16		Alarms are debounced: confirmed by several readings and held for a dwell time
+ * 1.17		Readings go through a rate limit and median filter that recovers from real fast changes
+ * 1.18		CPU sleeps between tasks, unused peripherals are off, displays can blank when nobody is around
+ * 1.19		Optional cycle counters for the drivers, interrupts and main tasks, reported as telemetry
+ * 1.20		Start-up moved to setup(), so the host benchmarks can run the firmware against mocked registers
+ * 1.21		Several DHT11 and DHT22 sensors on one port, read in turn, each with its own filters, alarms and history
+ * 1.22		History screens show a bar graph of the last 24 hours in custom LCD characters
+ * 1.23		LCD pages redraw on changes, alarms come on right away, the humidity history shows its maximum
+ * 1.24		Screen texts are read from flash, the stack high-water mark is measured and reported with GET MEMORY
+ * 1.25		Watchdog resets when a task stops checking in, the restart keeps the readings and history in RAM
  * 
  */
 
 // Include standard libraries
-#include <stdio.h>
 #include <stdlib.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
 
 // Include extra libraries
 #include <util/delay.h>
@@ -37,51 +62,159 @@
 #include "hd44780.h"  // Library for Liquid LED Display Screen
 #include "max7219/max7219.h"  // Library for LED Driver - LED Matrix
 #include "dht.h"  // Library for Temperature and Humidity sensor
+#include "sensor.h"  // Sensors on their pins, each with its own reading, filters and alarms
+#include "sched.h"  // Millisecond tick and cooperative task scheduler
+#include "tone.h"  // Square wave tones on the speaker pin
+#include "melody.h"  // Beep patterns for the different warnings
+#include "animation.h"  // Sprite animations on the LED matrix
+#include "history.h"  // Readings of the last 24 hours with rolling statistics
+#include "trend.h"  // Bar graph of the history in custom LCD characters
+#include "display.h"  // Pages of the LCD, redrawn when what they show changes
+#include "persist.h"  // Statistics and history saved in EEPROM
+#include "telemetry.h"  // Readings and alarm changes streamed over the UART
+#include "config.h"  // Settings that can be changed at run time
+#include "command.h"  // Serial commands to read and change the settings
+#include "alarm.h"  // Debounced alarm states for the limits
+#include "filter.h"  // Outlier filtering of the readings
+#include "power.h"  // Sleep between tasks and display blanking
+#include "profile.h"  // Cycle counters of the hot paths, built in with PROFILE 1
+#include "restart.h"  // Watchdog, and a warm restart that keeps the readings
 
 
 /**
  * USER CONFIGURATION
  * 
- * Set global limits for prefered alarms
- * Leave 'NULL' for no limit
+ * Set default limits for prefered alarms, in whole units
+ * Use CONFIG_NOLIMIT for no limit
  * Outside these boundries alarm rings
+ * These are used until other values are set over the UART, see command.h
  */
 #define TEMP_LIMIT_MIN 20
 #define TEMP_LIMIT_MAX 30
 #define HUM_LIMIT_MIN 20
 #define HUM_LIMIT_MAX 50
+#define LIMIT_HYSTERESIS 1		// distance a reading has to get back within a limit to end the alarm
+#define ALARM_CONFIRM 3			// readings out of the window that have to agree before an alarm starts or ends
+#define ALARM_WINDOW 4			// readings the alarms look back on, at most ALARM_WINDOW_MAX
+#define ALARM_DWELL_MS 10000	// least time an alarm stays on or off
+
+// Normally the lower limit can't be over the upper limit
+#if (TEMP_LIMIT_MIN != CONFIG_NOLIMIT && TEMP_LIMIT_MAX != CONFIG_NOLIMIT && TEMP_LIMIT_MIN > TEMP_LIMIT_MAX) \
+	|| (HUM_LIMIT_MIN != CONFIG_NOLIMIT && HUM_LIMIT_MAX != CONFIG_NOLIMIT && HUM_LIMIT_MIN > HUM_LIMIT_MAX)
+#error "Config error: limit MIN > MAX"
+#endif
 
 
 // Set defines & variables for global code usage
-#define SPEAKER_PIN PD5
-
-int8_t temp_exceeded_dir = 0;		// stores if limits are exceeded, either above or below set limit
-int8_t hum_exceeded_dir = 0;		
-int8_t current_animation = 1;		// stores current animation, in the form of LEDMATRIX_XXX byte arrays
-int8_t last_animation_done = 1;		// stores if current animation is done, prevents starting one before finishing
-int8_t test_frequency = 0;			// variable to keep track first few measurements are done. Sometimes first are incorrect
-int8_t display_step = 0;			// stores current step in different types of information
-
-int8_t temperature_max = 0;			// stores highest known temperature value
-int8_t temperature_min = 99;  		// stores lowest known temperature value. starts high to be overwriten by real data
-int8_t temperature_previous = 0;  	// stores last known value, to rule out unrealistic measurements by means of delta comparison.
-int8_t humidity_max = 0;
-int8_t humidity_min = 99;
-int8_t humidity_previous = 0;
-
-// DHT library checks for DHT model type
-// Reusable system for DHT22 which uses floats
-#if DHT_FLOAT == 0
-int8_t temperature = 0;
-int8_t humidity = 0;
-#elif DHT_FLOAT == 1
-float temperature = 0;
-float humidity = 0;
+#define WARNING_REPETITIONS 2		// times a warning pattern is played when the warning is shown
+#define MAX_DELTA 5					// largest realistic change between two measurements, in whole units
+#define FILTER_STAGES (FILTER_RATE | FILTER_MEDIAN)	// add FILTER_EMA to smooth the readings as well
+#define FILTER_RESYNC 3				// agreeing readings over MAX_DELTA after which the change is taken as real
+#define FILTER_EMA_SHIFT 2			// weight of a new reading in the average is 1 / 2^FILTER_EMA_SHIFT
+#define TREND_RANGE 2				// smallest spread the trend graph is scaled to, in whole units
+
+// Readings come in the unit of the DHT library: whole units, or tenths in DHT_FIXED mode
+// Settings in whole units are scaled once at compile time, so all checks stay integer compares
+#define SCALED(value) ((int16_t)(value) * DHT_SCALE)
+#define SCALED_LIMIT(value) ((value) == CONFIG_NOLIMIT ? CONFIG_NOLIMIT : SCALED(value))
+
+// Screen layout for the readings, the DHT22 needs room for the decimal
+// With more sensors the texts name the zone, ZONE_MARK is replaced by its number counting from 1
+// The texts stay in flash, they are printed with PSTR() and the _P functions of the LCD driver
+#define ZONE_MARK '#'
+#if SENSOR_COUNT == 1
+#define TEXT_TEMP_HISTORY "Temp 24h"		// followed by the trend graph
+#define TEXT_HUM_HISTORY "Hum. 24h"
+#define TEXT_TEMP_HIGH "HIGH TEMPERATURE"
+#define TEXT_TEMP_LOW "LOW TEMPERATURE "
+#define TEXT_HUM_HIGH "HIGH HUMIDITY   "
+#define TEXT_HUM_LOW "LOW HUMIDITY    "
+#define TEXT_SENSOR_ERROR "Bad sensor data."
+#else
+#define TEXT_TEMP_HISTORY "Zone # T"
+#define TEXT_HUM_HISTORY "Zone # H"
+#define TEXT_TEMP_HIGH "HIGH TEMP ZONE #"
+#define TEXT_TEMP_LOW "LOW TEMP ZONE # "
+#define TEXT_HUM_HIGH "HIGH HUM. ZONE #"
+#define TEXT_HUM_LOW "LOW HUM. ZONE # "
+#define TEXT_SENSOR_ERROR "Bad data zone # "
+#endif
+#if DHT_DECIMALS == 0
+#define VALUE_WIDTH 3				// characters for -99 up to 100
+#if SENSOR_COUNT == 1
+#define TEXT_TEMPERATURE "Temperature:"
+#define TEXT_HUMIDITY "Humidity:   "
+#else
+#define TEXT_TEMPERATURE "Zone # temp:"
+#define TEXT_HUMIDITY "Zone # hum.:"
+#endif
+#define TEXT_MIN "Min"
+#define TEXT_MAX "  Max"
+#define TEXT_OVER "Over"
+#define TEXT_UNDER "Under"
+#define TEXT_LIMIT " limit! "
+#else
+#define VALUE_WIDTH 5				// characters for -99.9 up to 100.0
+#if SENSOR_COUNT == 1
+#define TEXT_TEMPERATURE "Temp.:    "
+#define TEXT_HUMIDITY "Humidity: "
+#else
+#define TEXT_TEMPERATURE "Zone # T: "
+#define TEXT_HUMIDITY "Zone # H: "
+#endif
+#define TEXT_MIN "L"
+#define TEXT_MAX "  H"
+#define TEXT_OVER "Over "
+#define TEXT_UNDER "Under"
+#define TEXT_LIMIT " lim!"
 #endif
 
-// Array of 8 bytes
+// Task periods in milliseconds
+#define DISPLAY_STEP_MS 4194		// default time a page stays on, matches the former timer 1 overflow
+#define ANIMATION_FRAME_MS 120		// time per LED matrix animation frame
+#define SENSOR_SAMPLE_MS DHT_SAMPLEMS	// default time between two readings of a sensor, the sensor can't go faster
+#define DHT_POLL_MS 1				// time between checks on a running sensor reading
+#define MELODY_STEP_MS MELODY_TICK_MS	// time between steps of the warning pattern
+#define PERSIST_STEP_MS PERSIST_POLL_MS	// time between two EEPROM writes of a checkpoint
+#define COMMAND_STEP_MS COMMAND_POLL_MS	// time between checks for received commands
+#define POWER_STEP_MS POWER_POLL_MS	// time between checks on the display blanking
+
+// Task run-time budgets in microseconds
+#define DISPLAY_BUDGET_US 2000
+#define ANIMATION_BUDGET_US 1000
+#define DHT_BUDGET_US 300
+#define MELODY_BUDGET_US 100
+#define PERSIST_BUDGET_US 200
+#define COMMAND_BUDGET_US 500
+#define POWER_BUDGET_US 200
+#define PROFILE_BUDGET_US 300
+
+int8_t current_animation = 1;		// stores current animation, in the form of ANIMATION_XXX step lists
+// The readings, extremes, filters and alarms of every sensor are kept in sensors[], see sensor.h
+
+// Functions used before they are defined
+void printLabel_P(uint8_t sensor, const char *text);
+void printTempHum_Current(uint8_t sensor, int temperature, int humidity);
+void printTemp_History(uint8_t sensor, int temperature_max, int temperature_min);
+void printHum_History(uint8_t sensor, int humidity_max, int humidity_min);
+void printWarning(uint8_t sensor, int tempOrHum, int exceeded_dir);
+int isNewResultValid(sensor_t *sensor);
+void pageError(uint8_t sensor);
+void pageTempWarning(uint8_t sensor);
+void pageHumWarning(uint8_t sensor);
+void pageCurrent(uint8_t sensor);
+void pageTempHistory(uint8_t sensor);
+void pageHumHistory(uint8_t sensor);
+uint8_t hasError(uint8_t sensor);
+uint8_t hasTempAlarm(uint8_t sensor);
+uint8_t hasHumAlarm(uint8_t sensor);
+void alertTemp(uint8_t sensor);
+void alertHum(uint8_t sensor);
+void warningSounds(int tempOrHum, int exceeded_dir);
+
+// Array of 8 bytes, stored in flash
 // Each bit represents a bit in the 8x8LED matrix
-uint8_t LEDMATRIX_CHECK[] = {  // Check mark
+const uint8_t LEDMATRIX_CHECK[] PROGMEM = {  // Check mark
 	0b00000000, 
 	0b00000011, 
 	0b00000111, 
@@ -91,7 +224,7 @@ uint8_t LEDMATRIX_CHECK[] = {  // Check mark
 	0b11110000, 
 	0b01100000
 };
-uint8_t LEDMATRIX_WARNING[] = {  // Exlamation marks
+const uint8_t LEDMATRIX_WARNING[] PROGMEM = {  // Exlamation marks
 	0b00000000,
 	0b01100110,
 	0b01100110,
@@ -101,7 +234,7 @@ uint8_t LEDMATRIX_WARNING[] = {  // Exlamation marks
 	0b01100110,
 	0b00000000
 };
-uint8_t LEDMATRIX_HEART[] = {  // Heart
+const uint8_t LEDMATRIX_HEART[] PROGMEM = {  // Heart
 	0b00000000,
 	0b01100110,
 	0b10011001,
@@ -112,352 +245,512 @@ uint8_t LEDMATRIX_HEART[] = {  // Heart
 	0b00011000
 };
 
-/**
- * Interupt triggered by the overflow of timer 1A.
- */
-ISR(TIMER1_OVF_vect) {
-	// Check if temperature values are nominal, otherwise show warning
-	if (display_step == 0 && (temp_exceeded_dir == 1 || temp_exceeded_dir == -1)) {
-		printWarning(0, temp_exceeded_dir);
-	}
-	// Check if humidity values are nominal, otherwise show warning
-	else if(display_step == 1 && (hum_exceeded_dir == 1 || hum_exceeded_dir == -1)) {
-		printWarning(1, hum_exceeded_dir);
-	}
-	// If no warnings are present, first step is default current values display
-	else if(display_step <= 2) {
-		printTempHum_Current(temperature, humidity);
-	}
-	// Show the highest and lowest known temperature values
-	else if(display_step == 3) {
-		printTemp_History(temperature_max, temperature_min);
-	}
-	// Show the highest and lowest known humidity values
-	else if(display_step == 4) {
-		printHum_History(humidity, humidity_min);
-	}
-	
-	display_step++;  // Increase to the next display step
+// Animations, lists of steps stored in flash
+const animation_step_t ANIMATION_CHECK[] PROGMEM = {  // Slide the check mark in and out
+	{ANIMATION_SLIDE_IN, 0, LEDMATRIX_CHECK},
+	{ANIMATION_SLIDE_OUT, 0, LEDMATRIX_CHECK},
+	{ANIMATION_END, 0, 0}
+};
+const animation_step_t ANIMATION_WARNING[] PROGMEM = {  // Slide the exclamation marks in and out
+	{ANIMATION_SLIDE_IN, 0, LEDMATRIX_WARNING},
+	{ANIMATION_SLIDE_OUT, 0, LEDMATRIX_WARNING},
+	{ANIMATION_END, 0, 0}
+};
+const animation_step_t ANIMATION_HEART[] PROGMEM = {  // Fade the heart in and out
+	{ANIMATION_FADE_IN, 0, LEDMATRIX_HEART},
+	{ANIMATION_FADE_OUT, 0, LEDMATRIX_HEART},
+	{ANIMATION_END, 0, 0}
+};
 
-	if (display_step > 4) {  // Reset display stepthrough
-		display_step = 0;
-	}
-			
-	// Check if last animation is already done
-	if (last_animation_done == 1) {
-		last_animation_done = 0;  // Set flag so no new animations are started
+// Pages of every sensor, in the order of the rotation, stored in flash
+// Alarm and error pages are skipped while there is none, and come on right away when one starts
+const display_page_t DISPLAY_PAGES[] PROGMEM = {
+	{pageError, hasError, 0, DISPLAY_ERROR, 1},
+	{pageTempWarning, hasTempAlarm, alertTemp, DISPLAY_ALARM | DISPLAY_SETTINGS, 1},
+	{pageHumWarning, hasHumAlarm, alertHum, DISPLAY_ALARM | DISPLAY_SETTINGS, 1},
+	{pageCurrent, 0, 0, DISPLAY_READING, 0},
+	{pageTempHistory, 0, 0, DISPLAY_HISTORY, 0},
+	{pageHumHistory, 0, 0, DISPLAY_HISTORY, 0}
+};
+#define DISPLAY_PAGECOUNT (sizeof(DISPLAY_PAGES) / sizeof(DISPLAY_PAGES[0]))
 
+/**
+ * Function: Starts a new animation once the last one is done. Called every time a page comes on.
+ * Argument: None.
+ * Returns: None.
+ */
+void startAnimation(void) {
+	// Check if last animation is already done, prevents starting one before finishing
+	if (animation_done()) {
 		// Check which animation is currently required
 		if (current_animation == 0) {
-			matrixDisplay_animate(LEDMATRIX_CHECK, 1);
+			animation_play(ANIMATION_CHECK, 1);
 		}
 		else if(current_animation == 1) {
-			matrixDisplay_animate(LEDMATRIX_WARNING, 1);
+			animation_play(ANIMATION_WARNING, 1);
 		}
 		else {
-			matrixDisplay_animate(LEDMATRIX_HEART, 1);  // When in doubt, share some love
+			animation_play(ANIMATION_HEART, 1);  // When in doubt, share some love
 		}
-
-		last_animation_done = 1;  // After animation, clear flag
 	}
 }
 
 /**
- * Function: Displays the current temperature & humidity on the LCD screen.
- * Argument: Takes the temperature (in degrees Celcius) & humidity (in percentage) as integers.
+ * Functions: Pages of the display rotation, fill the frame buffer for a sensor.
+ * Argument: Sensor.
  * Returns: None.
  */
-void printTempHum_Current(int temperature, int humidity) {
-	char str[8];  // Array of chars to hold string values to be printed/displayed on the screen
-	sprintf(str, "%d", temperature);  // Converts the given integer argument to a string to fit the LCD display library
+void pageError(uint8_t sensor) {
+	lcd_buffer_goto(0);
+	lcd_buffer_puts_P(PSTR("Input Error:    "));
+	lcd_buffer_goto(0x40);
+	printLabel_P(sensor, PSTR(TEXT_SENSOR_ERROR));
+}
 
-	/* DISPLAY REGULAR TEMPERATURE */
-	lcd_goto(0);  // Set cursor to the beginning of the display
-	lcd_puts("Temperature: ");  // Print string to display
-	lcd_puts(str);  // Print string of current temp value to display
-	lcd_puts("C  ");  // Append Celcius indicator to value on display
+void pageTempWarning(uint8_t sensor) {
+	printWarning(sensor, 0, sensors[sensor].temperature_dir);
+}
 
-	sprintf(str, "%d", humidity);
+void pageHumWarning(uint8_t sensor) {
+	printWarning(sensor, 1, sensors[sensor].humidity_dir);
+}
 
-	lcd_goto(0x40);  // Set screen cursor to second line
-	lcd_puts("Humidity:    "); 
-	lcd_puts(str); 
-	lcd_puts("%  "); 
+void pageCurrent(uint8_t sensor) {
+	printTempHum_Current(sensor, sensors[sensor].temperature, sensors[sensor].humidity);
 }
 
+// Highest and lowest values of the last 24 hours
+void pageTempHistory(uint8_t sensor) {
+	uint8_t channel = HISTORY_CHANNEL(sensor, HISTORY_TEMPERATURE);
+
+	printTemp_History(sensor, history_max(channel, HISTORY_DAY), history_min(channel, HISTORY_DAY));
+}
+
+void pageHumHistory(uint8_t sensor) {
+	uint8_t channel = HISTORY_CHANNEL(sensor, HISTORY_HUMIDITY);
+
+	printHum_History(sensor, history_max(channel, HISTORY_DAY), history_min(channel, HISTORY_DAY));
+}
 
 /**
- * Function: Displays historic (highest & lowest) temperature values
- * Argument: Takes the temperature (in degrees Celcius) & humidity (in percentage) as integers.
- * Returns: None.
+ * Functions: Tell if the error or alarm page of a sensor is part of the rotation.
+ * Argument: Sensor.
+ * Returns: 1 while the last reading failed or the limit is exceeded, 0 otherwise.
  */
-void printTemp_History(int temperature_max, int temperature_min) {
-	lcd_goto(0);
-	lcd_puts("Temp. history:   ");
-
-	char str_max[8];
-	char str_min[8];
-
-	sprintf(str_max, "%d", temperature_max);
-	sprintf(str_min, "%d", temperature_min); 
-
-	lcd_goto(0x40);  // Set screen cursor to second line
-	lcd_puts("Min "); 
-	lcd_puts(str_min); 
-	lcd_puts("C Max "); 
-	lcd_puts(str_max);
-	lcd_puts("C   "); 
+uint8_t hasError(uint8_t sensor) {
+	return sensors[sensor].failed;
+}
+
+uint8_t hasTempAlarm(uint8_t sensor) {
+	return sensors[sensor].temperature_dir == ALARM_HIGH || sensors[sensor].temperature_dir == ALARM_LOW;
+}
+
+uint8_t hasHumAlarm(uint8_t sensor) {
+	return sensors[sensor].humidity_dir == ALARM_HIGH || sensors[sensor].humidity_dir == ALARM_LOW;
 }
 
 /**
- * Function: Displays historic (highest & lowest) humidity values
- * Argument: Takes the temperature (in degrees Celcius) & humidity (in percentage) as integers.
+ * Functions: Play the warning pattern when an alarm page comes on.
+ * Argument: Sensor.
  * Returns: None.
  */
-void printHum_History( humidity_max, humidity_min) {
-	lcd_goto(0);
-	lcd_puts("Hum. history:    ");
-
-	char str_max[8];
-	char str_min[8];
-
-	sprintf(str_max, "%d", humidity_max);
-	sprintf(str_min, "%d", humidity_min); 
-
-	lcd_goto(0x40);  // Set screen cursor to second line
-	lcd_puts("Min "); 
-	lcd_puts(str_min); 
-	lcd_puts("% Max "); 
-	lcd_puts(str_max);
-	lcd_puts("%   "); 
+void alertTemp(uint8_t sensor) {
+	warningSounds(0, sensors[sensor].temperature_dir);
+}
+
+void alertHum(uint8_t sensor) {
+	warningSounds(1, sensors[sensor].humidity_dir);
 }
 
 /**
- * Function: Plays the warning sound for a certain amount of milliseconds.
- * Argument: Time the sound should play in milliseconds.
+ * Function: Prints a text from flash, with the zone number of a sensor in place of ZONE_MARK.
+ * Arguments:
+ * 		1. Sensor.
+ * 		2. Text in flash, e.g. PSTR(TEXT_HUMIDITY).
  * Returns: None.
  */
-void warningSounds(int timeMs) {
-	// If so desired, the tuning/pitch of the noise can be tweaked by adjusting sounds_tuning
-	// This in turn increases loop size and shortens amplitude distance, as to maintain desired warningSounds length
-	uint8_t sounds_tuning = 2;
+void printLabel_P(uint8_t sensor, const char *text) {
+	char c;
 
-	for(size_t i = 0; i < timeMs * sounds_tuning; i++)  // timeMs * sounds_tuning creates 1ms, since every loop is devided by the same tuning
-	{
-		// use PWM to fake a analog signal
-		for(uint8_t i = 0; i < 255; i++){
-			if (100 > i) {
-				PORTD |= (1 << SPEAKER_PIN);
-			}
-			//clear pin
-			else {
-				PORTD &= ~(1 << SPEAKER_PIN);
-			}
-			
-		}
-		_delay_us(1000 / sounds_tuning);  // Sets a variable delay in amplitudes
+	while ((c = pgm_read_byte(text++))) {
+		lcd_buffer_putc(c == ZONE_MARK ? '1' + sensor : c);
 	}
 }
 
 /**
- * Functions: Animates an 8x8 image over led matrix.
- * Arguments:
- * 	1. Array of 8 bytes, each bit representing a LED.
- * 	2. Amount of animation repetitions.
- * Returns: none.
+ * Function: Displays the current temperature & humidity on the LCD screen.
+ * Argument: Takes the sensor, the temperature (in degrees Celcius) & humidity (in percentage) as integers, in the unit of the readings.
+ * Returns: None.
  */
-void matrixDisplay_animate(uint8_t row_list[8], uint8_t repetitions) {
+void printTempHum_Current(uint8_t sensor, int temperature, int humidity) {
+	/* DISPLAY REGULAR TEMPERATURE */
+	lcd_buffer_goto(0);  // Set cursor to the beginning of the display
+	printLabel_P(sensor, PSTR(TEXT_TEMPERATURE));  // Print string to display
+	lcd_buffer_putfixed(temperature, DHT_DECIMALS, VALUE_WIDTH, ' ');  // Right-aligned so shorter values overwrite longer ones
+	lcd_buffer_putc('C');  // Append Celcius indicator to value on display
+
+	lcd_buffer_goto(0x40);  // Set screen cursor to second line
+	printLabel_P(sensor, PSTR(TEXT_HUMIDITY)); 
+	lcd_buffer_putfixed(humidity, DHT_DECIMALS, VALUE_WIDTH, ' '); 
+	lcd_buffer_putc('%'); 
+}
 
-	uint8_t previous_value;
 
-	// Loop over animation x times
-	for(uint8_t repitition = 0; repitition < repetitions; repitition++)
-	{
-		// For 8 columns, fill every row
-		// Shift backwards, from right to left
-		for(int8_t column = 7; column >= 0; column--)
-		{
-			// Row after row with a small delay to animate
-			for(uint8_t row = 0; row < 8; row++)
-			{
-				max7219_digit(0, row, (row_list[row] >> column));
-			}
-			_delay_ms(120);
-		}
+/**
+ * Function: Displays historic (highest & lowest) temperature values, with the trend of the last 24 hours
+ * Argument: Takes the sensor, the temperature (in degrees Celcius) & humidity (in percentage) as integers.
+ * Returns: None.
+ */
+void printTemp_History(uint8_t sensor, int temperature_max, int temperature_min) {
+	lcd_buffer_goto(0);
+	printLabel_P(sensor, PSTR(TEXT_TEMP_HISTORY));
+	trend_put(HISTORY_CHANNEL(sensor, HISTORY_TEMPERATURE), SCALED(TREND_RANGE));  // Bars of 3 hours, only changed bars are sent
+
+	lcd_buffer_goto(0x40);  // Set screen cursor to second line
+	lcd_buffer_puts_P(PSTR(TEXT_MIN)); 
+	lcd_buffer_putfixed(temperature_min, DHT_DECIMALS, VALUE_WIDTH, ' '); 
+	lcd_buffer_putc('C'); 
+	lcd_buffer_puts_P(PSTR(TEXT_MAX)); 
+	lcd_buffer_putfixed(temperature_max, DHT_DECIMALS, VALUE_WIDTH, ' ');
+	lcd_buffer_putc('C'); 
+}
 
-		// Shift image back out of matrix
-		for(uint8_t column = 0; column < 8; column++)
-		{
-			for(uint8_t row = 0; row < 8; row++)
-			{
-				// grab every column of the image and slide it one left 
-				previous_value = max7219_getdigit(0, row);
-				max7219_digit(0, row, (previous_value << 1));
-			}
-			_delay_ms(120);
-		}
+/**
+ * Function: Displays historic (highest & lowest) humidity values, with the trend of the last 24 hours
+ * Argument: Takes the sensor, the temperature (in degrees Celcius) & humidity (in percentage) as integers.
+ * Returns: None.
+ */
+void printHum_History(uint8_t sensor, int humidity_max, int humidity_min) {
+	lcd_buffer_goto(0);
+	printLabel_P(sensor, PSTR(TEXT_HUM_HISTORY));
+	trend_put(HISTORY_CHANNEL(sensor, HISTORY_HUMIDITY), SCALED(TREND_RANGE));
+
+	lcd_buffer_goto(0x40);  // Set screen cursor to second line
+	lcd_buffer_puts_P(PSTR(TEXT_MIN)); 
+	lcd_buffer_putfixed(humidity_min, DHT_DECIMALS, VALUE_WIDTH, ' '); 
+	lcd_buffer_putc('%'); 
+	lcd_buffer_puts_P(PSTR(TEXT_MAX)); 
+	lcd_buffer_putfixed(humidity_max, DHT_DECIMALS, VALUE_WIDTH, ' ');
+	lcd_buffer_putc('%'); 
+}
+
+/**
+ * Function: Starts the warning pattern that belongs to an exceeded limit. Does not wait for the pattern to finish.
+ * Arguments: 
+ * 		1. If the exceeded attribute is temperature or humidity
+ *  	2. In which direction this attribute was exceeded.
+ * Returns: None.
+ */
+void warningSounds(int tempOrHum, int exceeded_dir) {
+	if (tempOrHum == 0) {
+		melody_play(exceeded_dir == 1 ? MELODY_TEMP_HIGH : MELODY_TEMP_LOW, WARNING_REPETITIONS);
+	}
+	else {
+		melody_play(exceeded_dir == 1 ? MELODY_HUM_HIGH : MELODY_HUM_LOW, WARNING_REPETITIONS);
 	}
+}
+
+/**
+ * Task: Advances the warning pattern that is playing.
+ * Runs every MELODY_STEP_MS milliseconds.
+ */
+void task_melody(void) {
+	melody_step();
+}
 
+/**
+ * Task: Draws the next frame of the current animation on the led matrix.
+ * Runs every ANIMATION_FRAME_MS milliseconds.
+ */
+void task_animation(void) {
+	animation_tick();  // Does nothing when no animation is running
 }
 
 /**
  * Functions: When called, sets the screen to display a warning to user. Can be used for either temp or hum, too high or low.
+ * The warning pattern is started by the page, see alertTemp().
  * Arguments: 
- * 		1. If the exceeded attribute is temperature or humidity
- *  	2. In which direction this attribute was exceeded.
+ * 		1. Sensor the warning is about
+ * 		2. If the exceeded attribute is temperature or humidity
+ *  	3. In which direction this attribute was exceeded.
  * Returns: none.
  */
-void printWarning(int tempOrHum, int exceeded_dir) {
-	char str[12];  // char array to hold set limit as string
-
-	lcd_goto(0);
+void printWarning(uint8_t sensor, int tempOrHum, int exceeded_dir) {
+	lcd_buffer_goto(0);
 
 	// First print the line describing which attribute it concerns to the user
 	if (tempOrHum == 0) {  // 0 == temperature
 		// either show too high or too low
 		if (exceeded_dir == 1) {
-			lcd_puts("HIGH TEMPERATURE");
-			lcd_goto(0x40);
-			lcd_puts("Over ");
-			sprintf(str, "%d", TEMP_LIMIT_MAX);
+			printLabel_P(sensor, PSTR(TEXT_TEMP_HIGH));
+			lcd_buffer_goto(0x40);
+			lcd_buffer_puts_P(PSTR(TEXT_OVER));
+			lcd_buffer_putfixed(config.temp_max, DHT_DECIMALS, VALUE_WIDTH, ' ');  // Display the limit the user has configured
 		}
 		else if (exceeded_dir == -1) {
-			lcd_puts("LOW TEMPERATURE ");
-			lcd_goto(0x40);
-			lcd_puts("Under ");
-			sprintf(str, "%d", TEMP_LIMIT_MIN);
+			printLabel_P(sensor, PSTR(TEXT_TEMP_LOW));
+			lcd_buffer_goto(0x40);
+			lcd_buffer_puts_P(PSTR(TEXT_UNDER));
+			lcd_buffer_putfixed(config.temp_min, DHT_DECIMALS, VALUE_WIDTH, ' ');
 		}
-		lcd_puts(str);  // Display the limit the user has configured
-		lcd_puts("C limit! ");
+		lcd_buffer_putc('C');
+		lcd_buffer_puts_P(PSTR(TEXT_LIMIT));
 
 	}
 	else if(tempOrHum == 1) {  // 1 == humidity
 		if (exceeded_dir == 1) {
-			lcd_puts("HIGH HUMIDITY   ");
-			lcd_goto(0x40);
-			lcd_puts("Over ");
-			sprintf(str, "%d", HUM_LIMIT_MAX);
+			printLabel_P(sensor, PSTR(TEXT_HUM_HIGH));
+			lcd_buffer_goto(0x40);
+			lcd_buffer_puts_P(PSTR(TEXT_OVER));
+			lcd_buffer_putfixed(config.hum_max, DHT_DECIMALS, VALUE_WIDTH, ' ');
 		}
 		else if (exceeded_dir == -1) {
-			lcd_puts("LOW HUMIDITY    ");
-			lcd_goto(0x40);
-			lcd_puts("Under ");
-			sprintf(str, "%d", HUM_LIMIT_MIN);
+			printLabel_P(sensor, PSTR(TEXT_HUM_LOW));
+			lcd_buffer_goto(0x40);
+			lcd_buffer_puts_P(PSTR(TEXT_UNDER));
+			lcd_buffer_putfixed(config.hum_min, DHT_DECIMALS, VALUE_WIDTH, ' ');
 		}
-		lcd_puts(str);
-		lcd_puts("% limit! ");
+		lcd_buffer_putc('%');
+		lcd_buffer_puts_P(PSTR(TEXT_LIMIT));
 	}
-
-	warningSounds(2000);  // play a warning sound to hold warning in place for time being
 }
 
 /**
- * Function: Uses new measured data and modifies global variables accordingly
- * Arguments: 
- * 		1. New current temperature data
- * 		2. New current humidity data
+ * Function: Uses new measured data and modifies the state of the sensors accordingly
+ * Argument: None, uses the fresh readings of the sensors.
  * Returns: None.
  */
-void checkStats(temperature, humidity) {
-	// Check if new data is valid, otherwise discard data
-	if (isNewResultValid() == 1) {
-		/* CHECK CURRENT VALUES EXCEED LIMITS */
-		// If temperature limit is set by user AND the current value exceeds this limit
-		if (TEMP_LIMIT_MAX != NULL && TEMP_LIMIT_MAX < temperature) {
-			temp_exceeded_dir = 1;  // Set global flag to temp OVER set limit
-			current_animation = 1;  // Set current animation to LEDMATRIX_WARNING
-		}
-		else if(TEMP_LIMIT_MIN != NULL && temperature < TEMP_LIMIT_MIN) {
-			temp_exceeded_dir = -1;  // Set global flag to temp UNDER set limit
-			current_animation = 1;
-		}
-		else {
-			temp_exceeded_dir = 0;  // If no limits are exceeded, return to default
-		}
+void checkStats(void) {
+	PROFILE_BEGIN(PROFILE_CHECKSTATS);
 
-		// If humidity limit is set AND the current value exceeds limits
-		if (HUM_LIMIT_MAX != NULL && HUM_LIMIT_MAX < humidity) {
-			hum_exceeded_dir = 1;
-			current_animation = 1;
-		}
-		else if(HUM_LIMIT_MIN != NULL && humidity < HUM_LIMIT_MIN) {
-			hum_exceeded_dir = -1;
-			current_animation = 1;  
+	uint8_t accepted = 0;
+
+	for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+		sensor_t *sensor = &sensors[i];
+
+		if (!sensor->fresh) {
+			continue;
 		}
-		else {
-			hum_exceeded_dir = 0;
+		sensor->fresh = 0;
+
+		// Check if new data is valid, otherwise discard data
+		if (isNewResultValid(sensor) != 1) {
+			continue;
 		}
+		accepted = 1;
 
-		// Only if both (temp & hum) limits aren't exceeded the warning animation is returned to CHECK
-		if (hum_exceeded_dir == 0 && temp_exceeded_dir == 0) {
-			current_animation = 0;
+		int8_t temp_previous_dir = sensor->temperature_dir;  // kept to report alarm changes
+		int8_t hum_previous_dir = sensor->humidity_dir;
+
+		/* CHECK CURRENT VALUES EXCEED LIMITS */
+		// Set flags to OVER (1) or UNDER (-1) the limits set by the user, 0 when within
+		// A flag only changes once enough readings agree and it has been held for the dwell time
+		sensor->temperature_dir = alarm_update(&sensor->temperature_alarm, sensor->temperature, config.temp_min, config.temp_max, sched_millis());
+		sensor->humidity_dir = alarm_update(&sensor->humidity_alarm, sensor->humidity, config.hum_min, config.hum_max, sched_millis());
+
+		/* STREAM OVER THE UART AND TELL THE DISPLAY */
+		telemetry_reading(i, sensor->temperature, sensor->humidity, DHT_DECIMALS);
+		display_event(i, DISPLAY_READING);
+		if (sensor->temperature_dir != temp_previous_dir || sensor->humidity_dir != hum_previous_dir) {
+			telemetry_alarm(i, sensor->temperature_dir, sensor->humidity_dir);
+			display_event(i, DISPLAY_ALARM);  // An alarm page comes on within DISPLAY_POLL_MS
 		}
-		
 
 		/* ADJUST STORED EXTREMES */
 		// If the highest known value is lower then the current value, then the current value is the new highest
-		if (temperature_max < temperature) {
-			temperature_max = temperature;
+		if (sensor->temperature_max < sensor->temperature) {
+			sensor->temperature_max = sensor->temperature;
 		}
 		// Idem for lowest known being higher then current value
-		if (temperature_min > temperature) {
-			temperature_min = temperature;
+		if (sensor->temperature_min > sensor->temperature) {
+			sensor->temperature_min = sensor->temperature;
 		}
 
-		if (humidity_max < humidity) {
-			humidity_max = humidity;
+		if (sensor->humidity_max < sensor->humidity) {
+			sensor->humidity_max = sensor->humidity;
 		}
 		
-		if (humidity_min > humidity) {
-			humidity_min = humidity;
+		if (sensor->humidity_min > sensor->humidity) {
+			sensor->humidity_min = sensor->humidity;
 		}
+
+		/* SAVE FOR THE NEXT BOOT */
+		persist_stats_t stats = {sensor->temperature_max, sensor->temperature_min, sensor->humidity_max, sensor->humidity_min};
+		persist_setstats(i, &stats);  // Only written to EEPROM when changed, by the persist task
+		sensor->valid = 1;
+		sensor->validtime = sched_millis();
 	}
+
+	if (accepted) {
+		uint8_t alarms = 0;
+		uint8_t valid = 1;
+		int16_t sample[HISTORY_CHANNELS];
+
+		for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+			if (sensors[i].temperature_dir != 0 || sensors[i].humidity_dir != 0) {
+				alarms = 1;
+			}
+			valid &= sensors[i].valid;
+			sample[HISTORY_CHANNEL(i, HISTORY_TEMPERATURE)] = sensors[i].temperature;
+			sample[HISTORY_CHANNEL(i, HISTORY_HUMIDITY)] = sensors[i].humidity;
+		}
+
+		// Only if no sensor exceeds its limits the warning animation is returned to CHECK
+		if (alarms) {
+			current_animation = 1;  // Set current animation to ANIMATION_WARNING
+			power_activity();  // An alarm has to be seen, keep the displays on
+		}
+		else {
+			current_animation = 0;
+		}
+
+		/* ADD TO THE HISTORY */
+		// Once every sensor has a reading, the last accepted one of every sensor goes in
+		if (valid) {
+			uint16_t stored = history_sequence();
+
+			history_add(sample);  // Averaged into a sample every HISTORY_PERIOD_MS, the screens read the windows from it
+			if (history_sequence() != stored) {
+				display_event(DISPLAY_SENSORS, DISPLAY_HISTORY);
+			}
+		}
+	}
+
+	PROFILE_END(PROFILE_CHECKSTATS);
 }
 
 /**
- * Function: Check if new measurements are valid by checking checking vs historic delta
- * Argument: None.
+ * Function: Check if new measurements are valid by running them through the filters, replaces them by the filtered values
+ * Argument: The sensor with the new measurement.
  * Returns: integer, either 0 (false) or 1 (true) 
  */
-int isNewResultValid() {
-	// The historic data first starts as 0 (zero) so overide first input to be valid
-	if (test_frequency < 1) {
-		temperature_previous = temperature;
-		humidity_previous = humidity;
-		test_frequency += 1;
-		return 1;
-	}
-
-	// If delta value is exceeds then 5 return false
-	// This means there is a bigger then 5 difference (unrealistic) in measurements
-	if (
-		(temperature - temperature_previous) < -5 ||
-		(temperature - temperature_previous) > 5
-	) {
-		return 0;
-	}
-
-	if (  
-		(humidity - humidity_previous) < -5 ||
-		(humidity - humidity_previous) > 5
-	) {
+int isNewResultValid(sensor_t *sensor) {
+	int16_t temperature_filtered;
+	int16_t humidity_filtered;
+
+	// Both filters always see the measurement, so they keep track of a real change in either one
+	int8_t temperature_status = filter_add(&sensor->temperature_filter, sensor->temperature, &temperature_filtered);
+	int8_t humidity_status = filter_add(&sensor->humidity_filter, sensor->humidity, &humidity_filtered);
+
+	// If either one is unrealistic, return false and keep showing the last accepted values
+	if (temperature_status != 0 || humidity_status != 0) {
+		sensor->temperature = sensor->temperature_previous;
+		sensor->humidity = sensor->humidity_previous;
 		return 0;
 	}
 
 	// When data is found plausible save it for later reference
-	temperature_previous = temperature;
-	humidity_previous = humidity;
+	sensor->temperature = temperature_filtered;
+	sensor->humidity = humidity_filtered;
+	sensor->temperature_previous = sensor->temperature;
+	sensor->humidity_previous = sensor->humidity;
 
 	return 1;
-	
 }
 
-int main(void)
-{	
+/**
+ * Task: Reads the sensors in turn, every one every SENSOR_SAMPLE_MS, and updates the stats once a reading is done.
+ * Runs every DHT_POLL_MS milliseconds.
+ */
+void task_dht(void) {
+	uint8_t index = 0;
+	int8_t status = sensor_sample(&index);
+
+	// Fetch temp & hum from sensor
+	if (status == DHT_READY) {
+		if (sensors[index].failed) {  // The error page goes out of the rotation
+			sensors[index].failed = 0;
+			display_event(index, DISPLAY_ERROR);
+		}
+		checkStats();
+	} else if (status == DHT_ERROR) {  // when fetch failes display corresponding error
+		sensors[index].failed = 1;
+		display_event(index, DISPLAY_ERROR);  // The error page comes on right away
+		current_animation = 1;
+
+		if (melody_playing() == MELODY_NONE) {  // Keep repeating while the sensor keeps failing
+			melody_play(MELODY_SENSOR_FAIL, 1);
+		}
+	}
+}
+
+/**
+ * Function: Applies a setting that was changed over the UART. Limits are used from the next reading on.
+ * Argument: The CONFIG_ key of the setting.
+ * Returns: None.
+ */
+void applySetting(uint8_t key) {
+	if (key == CONFIG_SAMPLE_MS) {
+		sensor_setinterval(config.sample_ms);
+	}
+	else if (key == CONFIG_DISPLAY_MS) {
+		display_setstep(config.display_ms);
+	}
+	else if (key <= CONFIG_HUM_MAX) {
+		display_event(DISPLAY_SENSORS, DISPLAY_SETTINGS);  // Alarm pages show the limits
+	}
+	else if (key == CONFIG_TELEMETRY) {
+		telemetry_setformat(config.telemetry);
+	}
+	else if (key == CONFIG_HYSTERESIS || key >= CONFIG_CONFIRM) {
+		alarm_configure(config.hysteresis, config.confirm, config.window, config.dwell_ms);
+	}
+}
+
+/**
+ * Function: Empties the filters and alarms of the sensors and brings back the statistics and history
+ * from before the reset, as far as the EEPROM has them. Used at a cold start.
+ * Argument: None.
+ * Returns: None.
+ */
+void restoreState(void) {
+	history_init();
+
+	// Bring back the statistics and history from before the reset
+	persist_stats_t stats[SENSOR_COUNT];
+	uint8_t restored = (persist_init(stats) == 0);
+
+	for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+		sensor_t *sensor = &sensors[i];
+
+		filter_init(&sensor->temperature_filter, FILTER_STAGES, SCALED(MAX_DELTA), FILTER_RESYNC, FILTER_EMA_SHIFT);
+		filter_init(&sensor->humidity_filter, FILTER_STAGES, SCALED(MAX_DELTA), FILTER_RESYNC, FILTER_EMA_SHIFT);
+		alarm_reset(&sensor->temperature_alarm);
+		alarm_reset(&sensor->humidity_alarm);
+
+		if (restored) {
+			sensor->temperature_max = stats[i].temperature_max;
+			sensor->temperature_min = stats[i].temperature_min;
+			sensor->humidity_max = stats[i].humidity_max;
+			sensor->humidity_min = stats[i].humidity_min;
+		}
+		else {
+			sensor->temperature_max = 0;  // Any reading is a new extreme
+			sensor->temperature_min = SCALED(99);
+			sensor->humidity_max = 0;
+			sensor->humidity_min = SCALED(99);
+		}
+	}
+}
+
+/**
+ * Function: Sets up the hardware, restores the saved state and registers the tasks. Interrupts stay off.
+ * After a watchdog reset the state in RAM is used when it is intact, see restart.h, otherwise the one in EEPROM.
+ * Argument: None.
+ * Returns: None.
+ */
+void setup(void) {
+	uint8_t warm = (restart_init() == RESTART_WARM);  // First, a cold start clears the kept state
+
 	/* SETUP LCD DISPLAY */
-	lcd_init();			// Initialize LCD
-	lcd_clrscr();		// Clear LCD
-	lcd_goto(0);		// Put cursor at start
+	if (warm) {
+		lcd_restart();  // The LCD kept its power, no need for the slow power-on sequence
+	}
+	else {
+		lcd_init();			// Initialize LCD
+		lcd_clrscr();		// Clear LCD
+	}
+	lcd_buffer_goto(0);		// Put cursor at start
 
 	/* SETUP LED DRIVER & MATRIX */
 	// Initialize LED driver
@@ -475,35 +768,61 @@ int main(void)
 	}
 
 	/* SETUP ARDUINO PINS */
-	DDRD |= (1 << SPEAKER_PIN);
+	tone_init();  // Speaker pin as output, silent
+	power_init();  // Switch off the ADC, TWI and analog comparator
+	telemetry_init();  // UART at UART_BAUD, sending starts once interrupts are enabled
+
+	/* LOAD SETTINGS */
+	// Saved settings from EEPROM, or the defaults above when none are saved
+	const config_t defaults = {
+		SCALED_LIMIT(TEMP_LIMIT_MIN), SCALED_LIMIT(TEMP_LIMIT_MAX),
+		SCALED_LIMIT(HUM_LIMIT_MIN), SCALED_LIMIT(HUM_LIMIT_MAX),
+		SCALED(LIMIT_HYSTERESIS), SENSOR_SAMPLE_MS, DISPLAY_STEP_MS, TELEMETRY_FORMAT,
+		ALARM_CONFIRM, ALARM_WINDOW, ALARM_DWELL_MS
+	};
+	config_init(&defaults);
+	config_setcallback(applySetting);
+	telemetry_setformat(config.telemetry);
+	alarm_configure(config.hysteresis, config.confirm, config.window, config.dwell_ms);
+
+	/* SETUP SENSORS */
+	sensor_init();  // Idle the sensor lines and enable their pin change interrupts
+	sensor_setinterval(config.sample_ms);
+
+	if (!warm) {
+		restoreState();  // A warm start still has the readings, filters, alarms and history in RAM
+	}
+
+	/* SETUP DISPLAY PAGES */
+	display_init(DISPLAY_PAGES, DISPLAY_PAGECOUNT, SENSOR_COUNT, config.display_ms);
+	display_setcallback(startAnimation);  // Every page that comes on starts the next animation
+
+	/* SETUP SCHEDULER */
+	sched_init();  // Timer 1 generates the millisecond tick
+	sched_add(display_task, DISPLAY_POLL_MS, DISPLAY_BUDGET_US);
+	sched_add(task_animation, ANIMATION_FRAME_MS, ANIMATION_BUDGET_US);
+	sched_add(task_melody, MELODY_STEP_MS, MELODY_BUDGET_US);
+	sched_add(persist_task, PERSIST_STEP_MS, PERSIST_BUDGET_US);
+	sched_add(command_task, COMMAND_STEP_MS, COMMAND_BUDGET_US);  // Settings are checked per command, see config_set()
+	sched_add(task_dht, DHT_POLL_MS, DHT_BUDGET_US);
+	sched_add(power_task, POWER_STEP_MS, POWER_BUDGET_US);
+#if PROFILE
+	profile_init();  // Timer 1 has to be running to measure the cost of a timestamp
+	sched_add(profile_task, PROFILE_REPORT_MS, PROFILE_BUDGET_US);
+#endif
+
+	restart_enable();  // From now on every task has to check in, or the watchdog resets
+}
 
-	/* SETUP TIMER */
-	TCCR1B |= (1 << CS12) | (1 << CS10);  // Set prescaler to 1024
-	TIMSK1 |= (1 << TOIE2);  // Overflow interrupt enabled when timers overflow
+int main(void)
+{
+	setup();
 	sei();  // Switch interrupts on
 
-	// Assert correct user config
-	// If it doesnt hook on the conditional, the while loop is allowed to run
-	// Normally the lower limit can't be over the upper limit
-	if (TEMP_LIMIT_MIN > TEMP_LIMIT_MAX || HUM_LIMIT_MIN > HUM_LIMIT_MAX) {
-		lcd_puts("Config error:");  // Display error type
-		lcd_goto(0x40);
-		lcd_puts("Limit MIN > MAX");  // Display specific error cause
-		current_animation = 1;
-		while(1){}  // Stay here untill problem is resolved		
-	} else {
-		while(1){
-			// Fetch temp & hum from sensor
-			if(dht_gettemperaturehumidity(&temperature, &humidity) != -1) {
-				checkStats(temperature, humidity);
-			} else {  // when fetch failes display corresponding error
-				lcd_puts("Input Error:"); 
-				lcd_goto(0x40);
-				lcd_puts("Bad sensor data.");
-				current_animation = 1;
-			}
-		}
-	}	
+	while(1){
+		sched_run();  // Run every task that is ready
+		power_idle();  // Sleep until the next interrupt when nothing is left to do
+	}
 
 	return 0;
 }
\ No newline at end of file
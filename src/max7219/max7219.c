@@ -12,10 +12,114 @@ Please refer to LICENSE file for licensing information.
 #include <avr/io.h>
 
 #include "max7219.h"
+#include "../profile.h"
 
+#if MAX7219_SPI == 2
+#include <avr/interrupt.h>
+#endif
 
-static uint8_t max7219_values[MAX7219_ICNUMBER][8];
+#if MAX7219_SPI == 2 && ((MAX7219_SPIQUEUESIZE & (MAX7219_SPIQUEUESIZE-1)) != 0 || MAX7219_SPIQUEUESIZE < 2*MAX7219_ICNUMBER)
+#error MAX7219_SPIQUEUESIZE must be a power of 2 and hold at least one transaction.
+#endif
+
+uint8_t max7219_values[MAX7219_ICNUMBER][8];
+static uint8_t max7219_sent[MAX7219_ICNUMBER][8]; //digit registers as last sent to the ics
+
+#if MAX7219_SPI == 2
+static uint8_t max7219_queue[MAX7219_SPIQUEUESIZE];
+static volatile uint8_t max7219_queuehead = 0; //next free position
+static volatile uint8_t max7219_queuetail = 0; //next byte to send
+static volatile uint8_t max7219_queuebusy = 0; //a byte is being shifted out
+static volatile uint8_t max7219_txcount = 0; //bytes sent of the current transaction
+
+/*
+ * start shifting out the next queued byte, load goes down at the start of every transaction
+ */
+static inline void max7219_queuestart() {
+	if(max7219_txcount == 0)
+		MAX7219_LOADPORT &= ~(1<<MAX7219_LOADINPUT); //load down
+	SPDR = max7219_queue[max7219_queuetail];
+	max7219_queuetail = (max7219_queuetail + 1) & (MAX7219_SPIQUEUESIZE-1);
+	max7219_queuebusy = 1;
+}
+
+/*
+ * a byte is out, latch finished transactions and send the next byte
+ */
+static inline void max7219_queuestep() {
+	if(++max7219_txcount == 2*MAX7219_ICNUMBER) {
+		MAX7219_LOADPORT |= (1<<MAX7219_LOADINPUT); //load up
+		max7219_txcount = 0;
+	}
+	if(max7219_queuetail != max7219_queuehead)
+		max7219_queuestart();
+	else
+		max7219_queuebusy = 0;
+}
 
+/*
+ * spi transfer complete
+ */
+ISR(SPI_STC_vect) {
+	max7219_queuestep();
+}
+
+/*
+ * advance the queue while waiting on it, with interrupts off, as in setup(), the
+ * interrupt can't run: the transfer complete flag is polled and its step done here
+ */
+static void max7219_queuepoll() {
+	if(SREG & (1<<SREG_I))
+		return;
+	if(max7219_queuebusy && (SPSR & (1<<SPIF))) {
+		(void)SPDR; //clears the flag, the interrupt won't run for this byte later
+		max7219_queuestep();
+	}
+}
+
+/*
+ * queue a byte, waits while the queue is full
+ */
+void max7219_shiftout(uint8_t bytedata) {
+	uint8_t next = (max7219_queuehead + 1) & (MAX7219_SPIQUEUESIZE-1);
+	while(next == max7219_queuetail) //wait for a free position
+		max7219_queuepoll();
+
+	max7219_queue[max7219_queuehead] = bytedata;
+
+	uint8_t sreg = SREG;
+	cli();
+	max7219_queuehead = next;
+	if(!max7219_queuebusy)
+		max7219_queuestart();
+	SREG = sreg;
+}
+
+/*
+ * check if queued data is still being sent
+ */
+uint8_t max7219_busy() {
+	return max7219_queuebusy;
+}
+
+/*
+ * wait until all queued data is sent
+ */
+void max7219_wait() {
+	while(max7219_queuebusy)
+		max7219_queuepoll();
+}
+
+#elif MAX7219_SPI == 1
+/*
+ * shift out a byte
+ */
+void max7219_shiftout(uint8_t bytedata) {
+	SPDR = bytedata;
+	while(!(SPSR & (1<<SPIF))); //wait for transfer complete, 16 cycles at fosc/2
+}
+
+#else
 /*
  * shift out a byte
  */
@@ -33,6 +137,26 @@ void max7219_shiftout(uint8_t bytedata) {
 		MAX7219_CLKPORT |= (1 << MAX7219_CLKINPUT); //set the serial-clock pin high
 	}
 }
+#endif
+
+
+/*
+ * start a transaction, in queue mode the interrupt takes care of the load line
+ */
+static inline void max7219_loaddown() {
+	#if MAX7219_SPI != 2
+	MAX7219_LOADPORT &= ~(1<<MAX7219_LOADINPUT); //load down
+	#endif
+}
+
+/*
+ * end a transaction, the ics latch the shifted data
+ */
+static inline void max7219_loadup() {
+	#if MAX7219_SPI != 2
+	MAX7219_LOADPORT |= (1<<MAX7219_LOADINPUT); //load up
+	#endif
+}
 
 
 /*
@@ -40,11 +164,12 @@ void max7219_shiftout(uint8_t bytedata) {
  */
 void max7219_send(uint8_t icnum, uint8_t reg, uint8_t data) {
 	uint8_t i = 0;
+	PROFILE_BEGIN(PROFILE_MAX7219_SEND);
 
 	if(icnum < MAX7219_ICNUMBER) {
-		MAX7219_LOADPORT &= ~(1<<MAX7219_LOADINPUT); //load down
+		max7219_loaddown();
 		//send no op to following ic
-		for(i=icnum; i<(MAX7219_ICNUMBER-1); i++) {
+		for(i=icnum+1; i<MAX7219_ICNUMBER; i++) {
 			max7219_shiftout(MAX7219_REGNOOP); //no op reg
 			max7219_shiftout(MAX7219_REGNOOP); //no op data
 		}
@@ -56,8 +181,56 @@ void max7219_send(uint8_t icnum, uint8_t reg, uint8_t data) {
 			max7219_shiftout(MAX7219_REGNOOP); //no op reg
 			max7219_shiftout(MAX7219_REGNOOP); //no op data
 		}
-		MAX7219_LOADPORT |= (1<<MAX7219_LOADINPUT); //load up
+		max7219_loadup();
+	}
+	PROFILE_END(PROFILE_MAX7219_SEND);
+}
+
+
+/*
+ * shift out one register to every ic in a single transaction, data[0] goes to ic 0
+ */
+void max7219_sendchain(uint8_t reg, const uint8_t *data) {
+	int8_t ic = 0;
+
+	max7219_loaddown();
+	//the last ic of the chain is shifted out first
+	for(ic=MAX7219_ICNUMBER-1; ic>=0; ic--) {
+		max7219_shiftout(reg);
+		max7219_shiftout(data[ic]);
+	}
+	max7219_loadup();
+}
+
+
+/*
+ * shift out the same register value to every ic in a single transaction
+ */
+void max7219_sendall(uint8_t reg, uint8_t data) {
+	uint8_t ic = 0;
+
+	max7219_loaddown();
+	for(ic=0; ic<MAX7219_ICNUMBER; ic++) {
+		max7219_shiftout(reg);
+		max7219_shiftout(data);
+	}
+	max7219_loadup();
+}
+
+
+/*
+ * send a row of the shadow buffer to every ic in a single transaction
+ */
+static void max7219_sendrow(uint8_t row) {
+	int8_t ic = 0;
+
+	max7219_loaddown();
+	for(ic=MAX7219_ICNUMBER-1; ic>=0; ic--) {
+		max7219_shiftout(MAX7219_REGDIGIT0 + row);
+		max7219_shiftout(max7219_values[ic][row]);
+		max7219_sent[ic][row] = max7219_values[ic][row];
 	}
+	max7219_loadup();
 }
 
 
@@ -109,6 +282,7 @@ void max7219_decode(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit0(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][0] = value;
+	max7219_sent[icnum][0] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT0, value);
 }
 
@@ -118,6 +292,7 @@ void max7219_digit0(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit1(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][1] = value;
+	max7219_sent[icnum][1] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT1, value);
 }
 
@@ -127,6 +302,7 @@ void max7219_digit1(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit2(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][2] = value;
+	max7219_sent[icnum][2] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT2, value);
 }
 
@@ -136,6 +312,7 @@ void max7219_digit2(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit3(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][3] = value;
+	max7219_sent[icnum][3] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT3, value);
 }
 
@@ -144,6 +321,7 @@ void max7219_digit3(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit4(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][4] = value;
+	max7219_sent[icnum][4] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT4, value);
 }
 
@@ -153,6 +331,7 @@ void max7219_digit4(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit5(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][5] = value;
+	max7219_sent[icnum][5] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT5, value);
 }
 
@@ -161,6 +340,7 @@ void max7219_digit5(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit6(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][6] = value;
+	max7219_sent[icnum][6] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT6, value);
 }
 
@@ -170,6 +350,7 @@ void max7219_digit6(uint8_t icnum, uint8_t value) {
  */
 void max7219_digit7(uint8_t icnum, uint8_t value) {
 	max7219_values[icnum][7] = value;
+	max7219_sent[icnum][7] = value;
 	max7219_send(icnum, MAX7219_REGDIGIT7, value);
 }
 
@@ -306,6 +487,64 @@ uint8_t max7219_getdigit(uint8_t icnum, uint8_t digit) {
 }
 
 
+/*
+ * get the shadow buffer of a selected ic, write the rows and call max7219_flush
+ */
+uint8_t *max7219_framebuffer(uint8_t icnum) {
+	if(icnum < MAX7219_ICNUMBER)
+		return max7219_values[icnum];
+	return max7219_values[0];
+}
+
+
+/*
+ * send every row that differs from the ics, one load pulse per row for the whole chain
+ */
+void max7219_flush() {
+	uint8_t row = 0;
+	uint8_t ic = 0;
+
+	for(row=0; row<8; row++) {
+		//look for any ic that needs this row
+		uint8_t dirty = 0;
+		for(ic=0; ic<MAX7219_ICNUMBER; ic++) {
+			if(max7219_values[ic][row] != max7219_sent[ic][row]) {
+				dirty = 1;
+				break;
+			}
+		}
+		if(dirty)
+			max7219_sendrow(row);
+	}
+}
+
+
+/*
+ * send the whole shadow buffer, 8 transactions for the whole chain
+ */
+void max7219_writeframe() {
+	uint8_t row = 0;
+
+	for(row=0; row<8; row++)
+		max7219_sendrow(row);
+}
+
+
+/*
+ * mark every row dirty, the next flush sends the whole buffer
+ */
+void max7219_invalidate() {
+	uint8_t row = 0;
+	uint8_t ic = 0;
+
+	for(ic=0; ic<MAX7219_ICNUMBER; ic++) {
+		for(row=0; row<8; row++) {
+			max7219_sent[ic][row] = ~max7219_values[ic][row];
+		}
+	}
+}
+
+
 /*
  * init the shift register
  */
@@ -318,5 +557,14 @@ void max7219_init() {
 	MAX7219_DINPORT &= ~(1 << MAX7219_DININPUT);
 	MAX7219_CLKPORT &= ~(1 << MAX7219_CLKINPUT);
 	MAX7219_LOADPORT &= ~(1 << MAX7219_LOADINPUT);
+	#if MAX7219_SPI != 0
+	//idle load high, load is on ss so it has to stay an output or the spi leaves master mode
+	MAX7219_LOADPORT |= (1 << MAX7219_LOADINPUT);
+	SPCR = (1<<SPE) | (1<<MSTR); //spi enabled, master, msb first, mode 0
+	SPSR = (1<<SPI2X); //fosc/2
+	#if MAX7219_SPI == 2
+	SPCR |= (1<<SPIE); //transfer complete interrupt
+	#endif
+	#endif
 }
 
@@ -13,21 +13,30 @@ Please refer to LICENSE file for licensing information.
 
 #include <avr/io.h>
 
+#include "../pins.h"
 
-//setup ports
-#define MAX7219_DINDDR DDRB
-#define MAX7219_DINPORT PORTB
-#define MAX7219_DININPUT PB3
-#define MAX7219_CLKDDR DDRB
-#define MAX7219_CLKPORT PORTB
-#define MAX7219_CLKINPUT PB5
-#define MAX7219_LOADDDR DDRB
-#define MAX7219_LOADPORT PORTB
-#define MAX7219_LOADINPUT PB2
+//setup ports, the pins are set in pins.h
+#define MAX7219_DINDDR PIN_DDRREG(BOARD_MAX7219_DIN)
+#define MAX7219_DINPORT PIN_PORTREG(BOARD_MAX7219_DIN)
+#define MAX7219_DININPUT PIN_BIT(BOARD_MAX7219_DIN)
+#define MAX7219_CLKDDR PIN_DDRREG(BOARD_MAX7219_CLK)
+#define MAX7219_CLKPORT PIN_PORTREG(BOARD_MAX7219_CLK)
+#define MAX7219_CLKINPUT PIN_BIT(BOARD_MAX7219_CLK)
+#define MAX7219_LOADDDR PIN_DDRREG(BOARD_MAX7219_LOAD)
+#define MAX7219_LOADPORT PIN_PORTREG(BOARD_MAX7219_LOAD)
+#define MAX7219_LOADINPUT PIN_BIT(BOARD_MAX7219_LOAD)
 
 //setup number of chip attached to the board
 #define MAX7219_ICNUMBER 1
 
+//setup transfer backend
+//0 = bit-banged shift out on any pins
+//1 = hardware SPI, polled (DIN on MOSI, CLK on SCK, LOAD on SS)
+//2 = hardware SPI, interrupt driven queue, max7219_send returns before the data is out,
+//    with interrupts off a full queue is drained by polling, so it works in setup() as well
+#define MAX7219_SPI 1
+#define MAX7219_SPIQUEUESIZE 32 //bytes, power of 2 and at least 2 * MAX7219_ICNUMBER
+
 //define registers
 #define MAX7219_REGNOOP 0x00
 #define MAX7219_REGDIGIT0 0x01
@@ -45,8 +54,13 @@ Please refer to LICENSE file for licensing information.
 #define MAX7219_REGTEST 0x0F
 
 
+//shadow buffer of every digit register, written by the digit functions or directly by the caller
+extern uint8_t max7219_values[MAX7219_ICNUMBER][8];
+
 //functions
 extern void max7219_send(uint8_t icnum, uint8_t reg, uint8_t data);
+extern void max7219_sendchain(uint8_t reg, const uint8_t *data);
+extern void max7219_sendall(uint8_t reg, uint8_t data);
 extern void max7219_shutdown(uint8_t icnum, uint8_t value);
 extern void max7219_intensity(uint8_t icnum, uint8_t value);
 extern void max7219_test(uint8_t icnum, uint8_t value);
@@ -70,6 +84,14 @@ extern uint8_t max7219_getdigit5(uint8_t icnum);
 extern uint8_t max7219_getdigit6(uint8_t icnum);
 extern uint8_t max7219_getdigit7(uint8_t icnum);
 extern uint8_t max7219_getdigit(uint8_t icnum, uint8_t digit);
+extern uint8_t *max7219_framebuffer(uint8_t icnum);
+extern void max7219_flush();
+extern void max7219_writeframe();
+extern void max7219_invalidate();
 extern void max7219_init();
+#if MAX7219_SPI == 2
+extern uint8_t max7219_busy();
+extern void max7219_wait();
+#endif
 
 #endif
@@ -0,0 +1,167 @@
+/*
+max7219 scrolling text
+
+Renders text in a 5x7 font as a banner over all chained ics.
+*/
+
+
+#include <stdio.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#include "max7219_scroll.h"
+
+
+//5x7 font from space to Z, one byte per column, bit 0 is the top row
+static const uint8_t max7219_scroll_font[][MAX7219_SCROLL_FONTWIDTH] PROGMEM = {
+	{0x00,0x00,0x00,0x00,0x00}, // space
+	{0x00,0x00,0x5F,0x00,0x00}, // !
+	{0x00,0x07,0x00,0x07,0x00}, // "
+	{0x14,0x7F,0x14,0x7F,0x14}, // #
+	{0x24,0x2A,0x7F,0x2A,0x12}, // $
+	{0x23,0x13,0x08,0x64,0x62}, // %
+	{0x36,0x49,0x55,0x22,0x50}, // &
+	{0x00,0x05,0x03,0x00,0x00}, // '
+	{0x00,0x1C,0x22,0x41,0x00}, // (
+	{0x00,0x41,0x22,0x1C,0x00}, // )
+	{0x08,0x2A,0x1C,0x2A,0x08}, // *
+	{0x08,0x08,0x3E,0x08,0x08}, // +
+	{0x00,0x50,0x30,0x00,0x00}, // ,
+	{0x08,0x08,0x08,0x08,0x08}, // -
+	{0x00,0x60,0x60,0x00,0x00}, // .
+	{0x20,0x10,0x08,0x04,0x02}, // /
+	{0x3E,0x51,0x49,0x45,0x3E}, // 0
+	{0x00,0x42,0x7F,0x40,0x00}, // 1
+	{0x42,0x61,0x51,0x49,0x46}, // 2
+	{0x21,0x41,0x45,0x4B,0x31}, // 3
+	{0x18,0x14,0x12,0x7F,0x10}, // 4
+	{0x27,0x45,0x45,0x45,0x39}, // 5
+	{0x3C,0x4A,0x49,0x49,0x30}, // 6
+	{0x01,0x71,0x09,0x05,0x03}, // 7
+	{0x36,0x49,0x49,0x49,0x36}, // 8
+	{0x06,0x49,0x49,0x29,0x1E}, // 9
+	{0x00,0x36,0x36,0x00,0x00}, // :
+	{0x00,0x56,0x36,0x00,0x00}, // ;
+	{0x00,0x08,0x14,0x22,0x41}, // <
+	{0x14,0x14,0x14,0x14,0x14}, // =
+	{0x41,0x22,0x14,0x08,0x00}, // >
+	{0x02,0x01,0x51,0x09,0x06}, // ?
+	{0x32,0x49,0x79,0x41,0x3E}, // @
+	{0x7E,0x11,0x11,0x11,0x7E}, // A
+	{0x7F,0x49,0x49,0x49,0x36}, // B
+	{0x3E,0x41,0x41,0x41,0x22}, // C
+	{0x7F,0x41,0x41,0x22,0x1C}, // D
+	{0x7F,0x49,0x49,0x49,0x41}, // E
+	{0x7F,0x09,0x09,0x01,0x01}, // F
+	{0x3E,0x41,0x41,0x51,0x32}, // G
+	{0x7F,0x08,0x08,0x08,0x7F}, // H
+	{0x00,0x41,0x7F,0x41,0x00}, // I
+	{0x20,0x40,0x41,0x3F,0x01}, // J
+	{0x7F,0x08,0x14,0x22,0x41}, // K
+	{0x7F,0x40,0x40,0x40,0x40}, // L
+	{0x7F,0x02,0x04,0x02,0x7F}, // M
+	{0x7F,0x04,0x08,0x10,0x7F}, // N
+	{0x3E,0x41,0x41,0x41,0x3E}, // O
+	{0x7F,0x09,0x09,0x09,0x06}, // P
+	{0x3E,0x41,0x51,0x21,0x5E}, // Q
+	{0x7F,0x09,0x19,0x29,0x46}, // R
+	{0x46,0x49,0x49,0x49,0x31}, // S
+	{0x01,0x01,0x7F,0x01,0x01}, // T
+	{0x3F,0x40,0x40,0x40,0x3F}, // U
+	{0x1F,0x20,0x40,0x20,0x1F}, // V
+	{0x7F,0x20,0x18,0x20,0x7F}, // W
+	{0x63,0x14,0x08,0x14,0x63}, // X
+	{0x03,0x04,0x78,0x04,0x03}, // Y
+	{0x61,0x51,0x49,0x45,0x43}  // Z
+};
+
+static const char *max7219_scroll_str = 0; //text being scrolled
+static uint8_t max7219_scroll_progmem = 0; //text lives in flash
+static uint8_t max7219_scroll_column = 0; //column of the current character, the last one is the blank spacer
+static uint16_t max7219_scroll_tail = 0; //blank columns left to scroll the text out of the banner
+
+/*
+ * start scrolling a text
+ */
+static void max7219_scroll_start(const char *text, uint8_t progmem) {
+	max7219_scroll_str = text;
+	max7219_scroll_progmem = progmem;
+	max7219_scroll_column = 0;
+	max7219_scroll_tail = 8 * MAX7219_ICNUMBER;
+}
+
+
+/*
+ * scroll a text from ram
+ */
+void max7219_scroll_text(const char *text) {
+	max7219_scroll_start(text, 0);
+}
+
+
+/*
+ * scroll a text from flash
+ */
+void max7219_scroll_text_P(const char *progmem_text) {
+	max7219_scroll_start(progmem_text, 1);
+}
+
+
+/*
+ * get the next column of the text, 0 when the text ended
+ */
+static uint8_t max7219_scroll_nextcolumn() {
+	char c = 0;
+	uint8_t column = 0;
+
+	if(max7219_scroll_str == 0)
+		return 0;
+
+	if(max7219_scroll_progmem)
+		c = pgm_read_byte(max7219_scroll_str);
+	else
+		c = *max7219_scroll_str;
+
+	if(c == 0) {
+		//text done, keep shifting in blank columns until the banner is empty
+		if(max7219_scroll_tail > 0)
+			max7219_scroll_tail--;
+		return 0;
+	}
+
+	if(c >= 'a' && c <= 'z')
+		c -= 'a' - 'A'; //the font only has capitals
+	if(c < MAX7219_SCROLL_FONTFIRST || c > MAX7219_SCROLL_FONTLAST)
+		c = '?';
+
+	if(max7219_scroll_column < MAX7219_SCROLL_FONTWIDTH)
+		column = pgm_read_byte(&max7219_scroll_font[c - MAX7219_SCROLL_FONTFIRST][max7219_scroll_column]);
+
+	if(++max7219_scroll_column > MAX7219_SCROLL_FONTWIDTH) {
+		max7219_scroll_column = 0;
+		max7219_scroll_str++;
+	}
+
+	return column;
+}
+
+
+/*
+ * move the banner one column to the left and flush it, returns 0 when the text has scrolled out
+ */
+uint8_t max7219_scroll_step() {
+	uint8_t row = 0;
+	uint8_t ic = 0;
+	uint8_t column = max7219_scroll_nextcolumn();
+
+	for(row=0; row<8; row++) {
+		//the leftmost led of every matrix comes from the matrix on its right
+		for(ic=1; ic<MAX7219_ICNUMBER; ic++)
+			max7219_values[ic-1][row] = (max7219_values[ic-1][row] << 1) | (max7219_values[ic][row] >> 7);
+		max7219_values[MAX7219_ICNUMBER-1][row] = (max7219_values[MAX7219_ICNUMBER-1][row] << 1) | ((column >> row) & 0x01);
+	}
+
+	max7219_flush();
+
+	return max7219_scroll_tail > 0;
+}
@@ -0,0 +1,27 @@
+/*
+max7219 scrolling text
+
+Renders text in a 5x7 font as a banner over all chained ics.
+Ic 0 is the leftmost matrix, the text enters on the right of the last ic
+and moves one column to the left on every max7219_scroll_step().
+*/
+
+
+#ifndef MAX7219_SCROLL_H_
+#define MAX7219_SCROLL_H_
+
+#include <avr/io.h>
+
+#include "max7219.h"
+
+//font size, one blank column is added after every character
+#define MAX7219_SCROLL_FONTWIDTH 5
+#define MAX7219_SCROLL_FONTFIRST ' '
+#define MAX7219_SCROLL_FONTLAST 'Z'
+
+//functions
+extern void max7219_scroll_text(const char *text);
+extern void max7219_scroll_text_P(const char *progmem_text);
+extern uint8_t max7219_scroll_step();
+
+#endif
@@ -0,0 +1,147 @@
+/**
+ * Title:   	Alarm pattern sequencer
+ *
+ * See melody.h for an explanation of the pattern tables.
+ */
+
+#include <avr/pgmspace.h>
+
+#include "melody.h"
+#include "tone.h"
+
+// Rising triple beep
+static const melody_note_t melody_temp_high[] PROGMEM = {
+	MELODY_NOTE(1500, 100), MELODY_REST(50),
+	MELODY_NOTE(2000, 100), MELODY_REST(50),
+	MELODY_NOTE(2500, 100), MELODY_REST(600),
+	MELODY_END
+};
+
+// Falling triple beep
+static const melody_note_t melody_temp_low[] PROGMEM = {
+	MELODY_NOTE(2500, 100), MELODY_REST(50),
+	MELODY_NOTE(2000, 100), MELODY_REST(50),
+	MELODY_NOTE(1500, 100), MELODY_REST(600),
+	MELODY_END
+};
+
+// Two long low beeps
+static const melody_note_t melody_hum_high[] PROGMEM = {
+	MELODY_NOTE(1000, 300), MELODY_REST(150),
+	MELODY_NOTE(1000, 300), MELODY_REST(250),
+	MELODY_END
+};
+
+// Three short low beeps
+static const melody_note_t melody_hum_low[] PROGMEM = {
+	MELODY_NOTE(1000, 80), MELODY_REST(80),
+	MELODY_NOTE(1000, 80), MELODY_REST(80),
+	MELODY_NOTE(1000, 80), MELODY_REST(600),
+	MELODY_END
+};
+
+// Warble, unlike any of the limit alarms
+static const melody_note_t melody_sensor_fail[] PROGMEM = {
+	MELODY_NOTE(800, 60), MELODY_NOTE(600, 60),
+	MELODY_NOTE(800, 60), MELODY_NOTE(600, 60),
+	MELODY_NOTE(800, 60), MELODY_NOTE(600, 60),
+	MELODY_NOTE(800, 60), MELODY_NOTE(600, 60),
+	MELODY_REST(520),
+	MELODY_END
+};
+
+// Pattern pointers, indexed by pattern number minus one
+static const melody_note_t * const melody_table[] PROGMEM = {
+	melody_temp_high,
+	melody_temp_low,
+	melody_hum_high,
+	melody_hum_low,
+	melody_sensor_fail
+};
+
+static const melody_note_t *melody_pattern = 0;  // pattern being played, in flash
+static const melody_note_t *melody_note = 0;  // next note to play
+static uint8_t melody_repetitions = 0;  // repetitions left after the current one
+static uint8_t melody_remaining = 0;  // ticks left of the current note
+static uint8_t melody_current = MELODY_NONE;
+
+/**
+ * Function: Starts playing a pattern, replacing the one that is playing.
+ * Arguments:
+ * 		1. Pattern number, one of the MELODY_XXX defines.
+ * 		2. Amount of repetitions, at least 1.
+ * Returns: None.
+ */
+void melody_play(uint8_t pattern, uint8_t repetitions) {
+	if (pattern == MELODY_NONE || pattern > sizeof(melody_table) / sizeof(melody_table[0]) || repetitions == 0) {
+		melody_stop();
+		return;
+	}
+
+	melody_pattern = (const melody_note_t *)pgm_read_ptr(&melody_table[pattern - 1]);
+	melody_note = melody_pattern;
+	melody_repetitions = repetitions - 1;
+	melody_remaining = 0;  // First note starts on the next step
+	melody_current = pattern;
+}
+
+/**
+ * Function: Stops the pattern that is playing.
+ * Argument: None.
+ * Returns: None.
+ */
+void melody_stop(void) {
+	melody_current = MELODY_NONE;
+	melody_pattern = 0;
+	tone_stop();
+}
+
+/**
+ * Function: Returns the pattern that is playing.
+ * Argument: None.
+ * Returns: pattern number, MELODY_NONE when silent.
+ */
+uint8_t melody_playing(void) {
+	return melody_current;
+}
+
+/**
+ * Function: Advances the pattern, starting the next note once the current one is over.
+ * Argument: None.
+ * Returns: None.
+ */
+void melody_step(void) {
+	if (melody_current == MELODY_NONE) {
+		return;
+	}
+
+	if (melody_remaining > 0) {
+		melody_remaining--;
+		if (melody_remaining > 0) {
+			return;
+		}
+	}
+
+	uint8_t frequency = pgm_read_byte(&melody_note->frequency);
+	uint8_t duration = pgm_read_byte(&melody_note->duration);
+
+	if (duration == 0) {  // End of the pattern
+		if (melody_repetitions == 0) {
+			melody_stop();
+			return;
+		}
+		melody_repetitions--;
+		melody_note = melody_pattern;
+		frequency = pgm_read_byte(&melody_note->frequency);
+		duration = pgm_read_byte(&melody_note->duration);
+	}
+	melody_note++;
+
+	if (frequency == 0) {
+		tone_stop();
+	}
+	else {
+		tone_start(frequency * 10, duration * MELODY_TICK_MS);  // Timer 0 ends the note by itself
+	}
+	melody_remaining = duration;
+}
@@ -0,0 +1,42 @@
+/**
+ * Title:   	Alarm pattern sequencer
+ *
+ * Plays beep patterns from PROGMEM note tables on the tone generator.
+ * melody_step() has to be called every MELODY_TICK_MS from a scheduler task, it only
+ * starts the next note when the current one is over and never blocks.
+ */
+
+#ifndef MELODY_H_
+#define MELODY_H_
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+//time between two calls of melody_step(), also the resolution of note durations
+#define MELODY_TICK_MS 10
+
+//a note of 10 Hz and 10 ms units, a frequency of 0 is a rest and a duration of 0 ends the pattern
+typedef struct {
+	uint8_t frequency;
+	uint8_t duration;
+} melody_note_t;
+
+#define MELODY_NOTE(hz, ms) {(hz) / 10, (ms) / MELODY_TICK_MS}
+#define MELODY_REST(ms) {0, (ms) / MELODY_TICK_MS}
+#define MELODY_END {0, 0}
+
+//patterns
+#define MELODY_NONE 0
+#define MELODY_TEMP_HIGH 1
+#define MELODY_TEMP_LOW 2
+#define MELODY_HUM_HIGH 3
+#define MELODY_HUM_LOW 4
+#define MELODY_SENSOR_FAIL 5
+
+//functions
+extern void melody_play(uint8_t pattern, uint8_t repetitions);
+extern void melody_stop(void);
+extern uint8_t melody_playing(void);
+extern void melody_step(void);
+
+#endif
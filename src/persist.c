@@ -0,0 +1,352 @@
+/**
+ * Title:   	EEPROM persistence
+ *
+ * See persist.h for the EEPROM layout and the checkpoint order.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+
+#include "persist.h"
+#include "history.h"
+#include "sched.h"
+#include "restart.h"
+
+//checkpoint states
+#define PERSIST_IDLE 0
+#define PERSIST_SAMPLES 1
+#define PERSIST_RECORD 2
+#define PERSIST_CONFIG 3
+
+//sequence number of an erased slot, never used for a record
+#define PERSIST_ERASED 0xFFFF
+
+//the history copy has to end within the EEPROM
+typedef char persist_layout_check[(PERSIST_HISTORY_ADDR + HISTORY_SIZE * HISTORY_CHANNELS <= PERSIST_EEPROM_SIZE) ? 1 : -1];
+
+// Where the checkpoints are is kept over a warm restart, see restart.h, persist_init() sets it up otherwise
+static uint32_t persist_checkpoint RESTART_NOINIT;	// millis the last checkpoint started
+static uint16_t persist_sequence RESTART_NOINIT;	// sequence number of the newest record
+static uint8_t persist_slot RESTART_NOINIT;			// slot of the newest record
+static uint8_t persist_count RESTART_NOINIT;		// history samples in the EEPROM ring
+static uint8_t persist_position RESTART_NOINIT;		// ring position of the newest saved sample
+static uint16_t persist_saved RESTART_NOINIT;		// history sequence of the newest saved sample
+static persist_stats_t persist_stats[SENSOR_COUNT] RESTART_NOINIT;		// statistics to save
+static persist_stats_t persist_savedstats[SENSOR_COUNT] RESTART_NOINIT;	// statistics in the newest record
+
+// A write that a reset broke off starts over, the record it was writing has no valid CRC yet
+static uint8_t persist_state = PERSIST_IDLE;
+static uint8_t persist_byte = 0;			// byte of the sample or record that is written next
+static persist_record_t persist_record;	// record that is being written
+static int8_t persist_deltas[HISTORY_CHANNELS];	// sample that is being written
+
+// A configuration that was not written yet is lost with a reset, like with a power loss
+static const uint8_t *persist_config = 0;	// configuration to write, followed by its CRC
+static uint8_t persist_configsize = 0;
+static uint8_t persist_configpending = 0;
+static uint8_t persist_configcrc = 0;
+
+/*
+ * EEPROM address of a log slot, and of a delta in the history ring
+ */
+static inline uint8_t *persist_slotaddress(uint8_t slot) {
+	return (uint8_t *)(uintptr_t)(PERSIST_LOG_ADDR + slot * sizeof(persist_record_t));
+}
+
+static inline uint8_t *persist_deltaaddress(uint8_t position, uint8_t channel) {
+	return (uint8_t *)(uintptr_t)(PERSIST_HISTORY_ADDR + position * HISTORY_CHANNELS + channel);
+}
+
+/**
+ * Function: Calculates the CRC of a record, seeded with the layout version.
+ * Argument: Record.
+ * Returns: CRC-8 over all bytes before the crc field.
+ */
+static uint8_t persist_crc(const persist_record_t *record) {
+	const uint8_t *bytes = (const uint8_t *)record;
+	uint8_t crc = PERSIST_VERSION;
+
+	for (uint8_t i = 0; i < offsetof(persist_record_t, crc); i++) {
+		crc = _crc_ibutton_update(crc, bytes[i]);
+	}
+	return crc;
+}
+
+/**
+ * Function: Checks a record read from EEPROM.
+ * Argument: Record.
+ * Returns: 1 when it is intact and fits the current layout, 0 otherwise.
+ */
+static uint8_t persist_valid(const persist_record_t *record) {
+	return record->sequence != PERSIST_ERASED
+		&& record->count <= HISTORY_SIZE
+		&& record->position < HISTORY_SIZE
+		&& record->crc == persist_crc(record);
+}
+
+/**
+ * Function: Calculates the CRC of the configuration in EEPROM, seeded with the layout version and its size.
+ * Argument: Size of the configuration.
+ * Returns: CRC-8 over the configuration.
+ */
+static uint8_t persist_storedconfigcrc(uint8_t size) {
+	uint8_t crc = PERSIST_VERSION ^ size;
+
+	for (uint8_t i = 0; i < size; i++) {
+		crc = _crc_ibutton_update(crc, eeprom_read_byte((const uint8_t *)(uintptr_t)(PERSIST_CONFIG_ADDR + i)));
+	}
+	return crc;
+}
+
+/**
+ * Function: Puts the history samples of a record back, oldest first. Leaves the history empty when the record has none.
+ * Argument: Record.
+ * Returns: None.
+ */
+static void persist_loadhistory(const persist_record_t *record) {
+	int16_t values[HISTORY_CHANNELS];
+	uint8_t position = record->position;
+
+	if (record->count == 0) {
+		return;  // No samples were saved, newest holds no reading
+	}
+
+	// Walk back from the newest sample to the value of the oldest one
+	memcpy(values, record->newest, sizeof(values));
+	for (uint8_t i = 1; i < record->count; i++) {
+		for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+			values[ch] -= (int8_t)eeprom_read_byte(persist_deltaaddress(position, ch));
+		}
+		position = (position + HISTORY_SIZE - 1) % HISTORY_SIZE;
+	}
+
+	history_load(values);
+	for (uint8_t i = 1; i < record->count; i++) {
+		position = (position + 1) % HISTORY_SIZE;
+		for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+			values[ch] += (int8_t)eeprom_read_byte(persist_deltaaddress(position, ch));
+		}
+		history_load(values);
+	}
+}
+
+/**
+ * Function: Takes the next history sample that is not in EEPROM yet.
+ * Argument: None.
+ * Returns: 1 when persist_deltas holds a sample to write, 0 when all samples are saved.
+ */
+static uint8_t persist_nextsample(void) {
+	int16_t values[HISTORY_CHANNELS];
+	int16_t previous[HISTORY_CHANNELS];
+	uint16_t age = history_sequence() - persist_saved - 1;
+
+	if (persist_saved == history_sequence() || age >= history_count()) {
+		return 0;
+	}
+
+	history_get(age, values, NULL);
+	if (persist_count == 0 || history_get(age + 1, previous, NULL) != 0) {
+		memcpy(previous, values, sizeof(previous));  // The delta of the oldest sample is never used
+	}
+	for (uint8_t ch = 0; ch < HISTORY_CHANNELS; ch++) {
+		persist_deltas[ch] = values[ch] - previous[ch];
+	}
+	return 1;
+}
+
+/**
+ * Function: Fills in the record for the samples and statistics that have been saved.
+ * Argument: None.
+ * Returns: None.
+ */
+static void persist_preparerecord(void) {
+	persist_record.sequence = persist_sequence + 1;
+	if (persist_record.sequence == PERSIST_ERASED) {
+		persist_record.sequence = 0;
+	}
+	memcpy(persist_record.stats, persist_stats, sizeof(persist_stats));
+	memset(persist_record.newest, 0, sizeof(persist_record.newest));
+	if (persist_count) {
+		history_get(history_sequence() - persist_saved, persist_record.newest, NULL);
+	}
+	persist_record.count = persist_count;
+	persist_record.position = persist_position;
+	persist_record.crc = persist_crc(&persist_record);
+}
+
+/**
+ * Function: Restores the newest intact checkpoint. Call once at a cold start, after history_init().
+ * Argument: Receives the saved statistics of every sensor, left untouched when there is no checkpoint.
+ * Returns: 0 when a checkpoint was restored, -1 when the EEPROM holds none.
+ */
+int8_t persist_init(persist_stats_t stats[SENSOR_COUNT]) {
+	persist_record_t record;
+	int8_t found = -1;
+
+	persist_sequence = 0;
+	persist_slot = PERSIST_SLOTS - 1;  // The first checkpoint goes to slot 0
+	persist_count = 0;
+	persist_position = HISTORY_SIZE - 1;
+	persist_saved = 0;
+
+	for (uint8_t slot = 0; slot < PERSIST_SLOTS; slot++) {
+		eeprom_read_block(&record, persist_slotaddress(slot), sizeof(record));
+		if (persist_valid(&record) && (found < 0 || (int16_t)(record.sequence - persist_record.sequence) > 0)) {
+			persist_record = record;
+			found = slot;
+		}
+	}
+
+	persist_checkpoint = sched_millis();
+	if (found < 0) {
+		return -1;
+	}
+
+	persist_loadhistory(&persist_record);
+
+	persist_slot = found;
+	persist_sequence = persist_record.sequence;
+	persist_count = persist_record.count;
+	persist_position = persist_record.position;
+	persist_saved = history_sequence();
+	memcpy(persist_stats, persist_record.stats, sizeof(persist_stats));
+	memcpy(persist_savedstats, persist_record.stats, sizeof(persist_savedstats));
+	memcpy(stats, persist_record.stats, sizeof(persist_stats));
+	return 0;
+}
+
+/**
+ * Function: Sets the statistics of a sensor the next checkpoint saves.
+ * Arguments:
+ * 		1. Sensor.
+ * 		2. Statistics.
+ * Returns: None.
+ */
+void persist_setstats(uint8_t sensor, const persist_stats_t *stats) {
+	persist_stats[sensor] = *stats;
+}
+
+/**
+ * Function: Reads the configuration block.
+ * Arguments:
+ * 		1. Receives the configuration, left untouched when the block is not valid.
+ * 		2. Size of the configuration, less than PERSIST_CONFIG_SIZE.
+ * Returns: 0 when the configuration was read, -1 when the block is empty or damaged.
+ */
+int8_t persist_loadconfig(void *config, uint8_t size) {
+	if (size >= PERSIST_CONFIG_SIZE) {
+		return -1;
+	}
+	if (eeprom_read_byte((const uint8_t *)(uintptr_t)(PERSIST_CONFIG_ADDR + size)) != persist_storedconfigcrc(size)) {
+		return -1;
+	}
+
+	eeprom_read_block(config, (const void *)(uintptr_t)PERSIST_CONFIG_ADDR, size);
+	return 0;
+}
+
+/**
+ * Function: Schedules the configuration to be written by the persist task. Returns right away.
+ * Arguments:
+ * 		1. Configuration, has to stay in place, changes until it is written are saved as well.
+ * 		2. Size of the configuration, less than PERSIST_CONFIG_SIZE.
+ * Returns: None.
+ */
+void persist_saveconfig(const void *config, uint8_t size) {
+	if (size >= PERSIST_CONFIG_SIZE) {
+		return;
+	}
+	persist_config = config;
+	persist_configsize = size;
+	persist_configpending = 1;
+}
+
+/**
+ * Function: Tells if a checkpoint is being written.
+ * Argument: None.
+ * Returns: 1 while writing, 0 otherwise.
+ */
+uint8_t persist_busy(void) {
+	return persist_state != PERSIST_IDLE || persist_configpending;
+}
+
+/**
+ * Task: Starts a configuration write or a checkpoint when something changed, and writes it a byte at a time.
+ * Runs every PERSIST_POLL_MS milliseconds.
+ */
+void persist_task(void) {
+	if (persist_state == PERSIST_IDLE && persist_configpending) {
+		persist_configpending = 0;  // Set again when the configuration changes while it is written
+		persist_configcrc = PERSIST_VERSION ^ persist_configsize;
+		persist_state = PERSIST_CONFIG;
+		persist_byte = 0;
+	}
+
+	if (persist_state == PERSIST_IDLE) {
+		if (sched_millis() - persist_checkpoint < PERSIST_INTERVAL_MS) {
+			return;
+		}
+		if (persist_saved == history_sequence() && memcmp(persist_stats, persist_savedstats, sizeof(persist_stats)) == 0) {
+			return;
+		}
+
+		persist_checkpoint = sched_millis();
+		if ((uint16_t)(history_sequence() - persist_saved) > history_count()) {
+			// Samples were dropped before they were saved, the EEPROM ring starts over
+			persist_saved = history_sequence() - history_count();
+			persist_count = 0;
+		}
+		persist_state = PERSIST_SAMPLES;
+		persist_byte = 0;
+	}
+
+	if (!eeprom_is_ready()) {
+		return;
+	}
+
+	if (persist_state == PERSIST_SAMPLES) {
+		if (persist_byte == 0 && !persist_nextsample()) {
+			persist_preparerecord();
+			persist_state = PERSIST_RECORD;
+			return;
+		}
+
+		uint8_t position = (persist_position + 1) % HISTORY_SIZE;
+		eeprom_update_byte(persist_deltaaddress(position, persist_byte), persist_deltas[persist_byte]);
+
+		if (++persist_byte == HISTORY_CHANNELS) {
+			persist_byte = 0;
+			persist_position = position;
+			persist_saved++;
+			if (persist_count < HISTORY_SIZE) {
+				persist_count++;
+			}
+		}
+	}
+	else if (persist_state == PERSIST_RECORD) {
+		uint8_t slot = (persist_slot + 1) % PERSIST_SLOTS;
+		eeprom_update_byte(persist_slotaddress(slot) + persist_byte, ((const uint8_t *)&persist_record)[persist_byte]);
+
+		if (++persist_byte == sizeof(persist_record)) {  // The CRC is written last and completes the record
+			persist_slot = slot;
+			persist_sequence = persist_record.sequence;
+			memcpy(persist_savedstats, persist_record.stats, sizeof(persist_savedstats));
+			persist_state = PERSIST_IDLE;
+		}
+	}
+	else if (persist_state == PERSIST_CONFIG) {
+		if (persist_byte < persist_configsize) {
+			uint8_t data = persist_config[persist_byte];
+			persist_configcrc = _crc_ibutton_update(persist_configcrc, data);  // Over what is written, in case it changes meanwhile
+			eeprom_update_byte((uint8_t *)(uintptr_t)(PERSIST_CONFIG_ADDR + persist_byte), data);
+			persist_byte++;
+		}
+		else {
+			eeprom_update_byte((uint8_t *)(uintptr_t)(PERSIST_CONFIG_ADDR + persist_byte), persist_configcrc);
+			persist_state = PERSIST_IDLE;
+		}
+	}
+}
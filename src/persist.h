@@ -0,0 +1,68 @@
+/**
+ * Title:   	EEPROM persistence
+ *
+ * Saves the statistics and the reading history in EEPROM, so they survive a reset.
+ *
+ * The EEPROM holds a configuration block, a log of PERSIST_SLOTS records and a copy
+ * of the history ring. Every checkpoint writes the record to the next slot of the log,
+ * which spreads the wear of the often changing values over all slots. A record carries
+ * a sequence number and a CRC: at boot the newest intact one is used, so a checkpoint
+ * interrupted by a power loss falls back to the one before it. New history samples are
+ * written to the ring before the record that refers to them.
+ *
+ * persist_task() writes at most one byte per run and only when the EEPROM is ready,
+ * so the main loop never waits for the 3.3 ms an EEPROM write takes. Checkpoints are
+ * only made when something changed and at most once every PERSIST_INTERVAL_MS.
+ * A changed configuration is written by the same task, ahead of the next checkpoint.
+ */
+
+#ifndef PERSIST_H_
+#define PERSIST_H_
+
+#include <stdint.h>
+
+#include "history.h"
+#include "sensor.h"
+
+//time between two checkpoints, every slot is then written once every PERSIST_SLOTS * 10 minutes
+#define PERSIST_INTERVAL_MS 600000UL
+
+//time between two runs of persist_task(), an EEPROM write takes 3.3 ms
+#define PERSIST_POLL_MS 4
+
+//EEPROM layout
+#define PERSIST_CONFIG_ADDR 0x000
+#define PERSIST_CONFIG_SIZE 32
+#define PERSIST_LOG_ADDR (PERSIST_CONFIG_ADDR + PERSIST_CONFIG_SIZE)
+#define PERSIST_SLOTS (16 / SENSOR_COUNT)	// fewer with more sensors, their records and history take more room
+#define PERSIST_HISTORY_ADDR (PERSIST_LOG_ADDR + PERSIST_SLOTS * sizeof(persist_record_t))
+#define PERSIST_EEPROM_SIZE 1024
+
+//increase when the layout changes, records of an older layout are ignored
+#define PERSIST_VERSION 1
+
+typedef struct {
+	int16_t temperature_max;
+	int16_t temperature_min;
+	int16_t humidity_max;
+	int16_t humidity_min;
+} persist_stats_t;
+
+typedef struct {
+	uint16_t sequence;					// increases with every checkpoint, the highest one is the newest
+	persist_stats_t stats[SENSOR_COUNT];
+	int16_t newest[HISTORY_CHANNELS];	// values of the newest history sample
+	uint8_t count;						// history samples in the ring
+	uint8_t position;					// ring position of the newest history sample
+	uint8_t crc;						// over all previous bytes, seeded with PERSIST_VERSION
+} persist_record_t;
+
+//functions
+extern int8_t persist_init(persist_stats_t stats[SENSOR_COUNT]);
+extern void persist_setstats(uint8_t sensor, const persist_stats_t *stats);
+extern int8_t persist_loadconfig(void *config, uint8_t size);
+extern void persist_saveconfig(const void *config, uint8_t size);
+extern uint8_t persist_busy(void);
+extern void persist_task(void);
+
+#endif
@@ -0,0 +1,90 @@
+/**
+ * Title:   	Board pin map
+ *
+ * The clock of the board is set here as well, every header that needs F_CPU includes
+ * this one, so the value is defined once.
+ *
+ * Every pin of the board is defined once here, as its port letter and bit. The PIN_
+ * macros take such a pin and expand to the registers of its port at compile time, so
+ * PIN_HIGH(BOARD_TONE) becomes PORTD |= (1 << 5), a single sbi instruction, and no
+ * driver needs a lookup or a switch to find its pins. A pin is moved here, for every
+ * driver that uses it: the setup macros of the drivers are taken from this map.
+ *
+ * The pins of a port share its pin change interrupt, so all sensors of sensor.h have
+ * to be on the port of BOARD_DHT1.
+ */
+
+#ifndef PINS_H_
+#define PINS_H_
+
+#include <avr/io.h>
+
+//CPU clock, can be set from the build flags instead
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+//LCD, see hd44780_settings.h
+#define BOARD_LCD_RS D, 7
+#define BOARD_LCD_RW C, 4			// PC6 is the reset pin on the ATmega328, A4 (PC4) is free
+#define BOARD_LCD_E B, 0
+#define BOARD_LCD_DB4 C, 0
+#define BOARD_LCD_DB5 C, 1
+#define BOARD_LCD_DB6 C, 2
+#define BOARD_LCD_DB7 C, 3
+
+//LED matrix driver, on the hardware SPI pins: DIN on MOSI, CLK on SCK, LOAD on SS
+#define BOARD_MAX7219_DIN B, 3
+#define BOARD_MAX7219_CLK B, 5
+#define BOARD_MAX7219_LOAD B, 2
+
+//speaker, has to be the OC0B pin
+#define BOARD_TONE D, 5
+
+//temperature and humidity sensors, one line each on the same port
+#define BOARD_DHT1 D, 6
+#define BOARD_DHT2 D, 4
+
+//optional LCD backlight transistor, see power.h
+//#define BOARD_BACKLIGHT B, 1
+
+//registers and bit of a pin
+#define PIN_PORTREG(pin) PIN_PORTREG_(pin)
+#define PIN_DDRREG(pin) PIN_DDRREG_(pin)
+#define PIN_INREG(pin) PIN_INREG_(pin)
+#define PIN_BIT(pin) PIN_BIT_(pin)
+#define PIN_MASK(pin) PIN_MASK_(pin)
+
+//pin change interrupt of the port of a pin: enable bit in PCICR, mask register and vector
+#define PIN_PCIE(pin) PIN_PCIE_(pin)
+#define PIN_PCMSK(pin) PIN_PCMSK_(pin)
+#define PIN_PCINTVECT(pin) PIN_PCINTVECT_(pin)
+
+//single-instruction accesses
+#define PIN_HIGH(pin) (PIN_PORTREG_(pin) |= PIN_MASK_(pin))
+#define PIN_LOW(pin) (PIN_PORTREG_(pin) &= ~PIN_MASK_(pin))
+#define PIN_OUTPUT(pin) (PIN_DDRREG_(pin) |= PIN_MASK_(pin))
+#define PIN_INPUT(pin) (PIN_DDRREG_(pin) &= ~PIN_MASK_(pin))
+#define PIN_READ(pin) ((PIN_INREG_(pin) & PIN_MASK_(pin)) != 0)
+
+//the expansions above split a pin into its port letter and bit
+#define PIN_PORTREG_(port, bit) PORT##port
+#define PIN_DDRREG_(port, bit) DDR##port
+#define PIN_INREG_(port, bit) PIN##port
+#define PIN_BIT_(port, bit) (bit)
+#define PIN_MASK_(port, bit) (1 << (bit))
+#define PIN_PCIE_(port, bit) PIN_PCIE_##port
+#define PIN_PCMSK_(port, bit) PIN_PCMSK_##port
+#define PIN_PCINTVECT_(port, bit) PIN_PCINTVECT_##port
+
+#define PIN_PCIE_B PCIE0
+#define PIN_PCIE_C PCIE1
+#define PIN_PCIE_D PCIE2
+#define PIN_PCMSK_B PCMSK0
+#define PIN_PCMSK_C PCMSK1
+#define PIN_PCMSK_D PCMSK2
+#define PIN_PCINTVECT_B PCINT0_vect
+#define PIN_PCINTVECT_C PCINT1_vect
+#define PIN_PCINTVECT_D PCINT2_vect
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * Title:   	Power saving
+ *
+ * See power.h for the sleep mode and the current estimates.
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/power.h>
+#include <avr/sleep.h>
+
+#include "power.h"
+#include "sched.h"
+#include "hd44780.h"
+#include "max7219/max7219.h"
+
+static uint32_t power_slept = 0;			// microseconds asleep in the current window
+static uint32_t power_windowstart = 0;			// micros the current window started
+static uint16_t power_ratio = 0;				// per mille of the last window spent asleep
+static uint32_t power_lastactivity = 0;		// millis of the last alarm or command
+static uint8_t power_blanked = 0;
+
+/**
+ * Function: Switches the LCD and the LED matrix on or off, their contents are kept.
+ * Argument: 1 to switch them on, 0 for off.
+ * Returns: None.
+ */
+static void power_displays(uint8_t on) {
+	if (on) {
+		lcd_command(_BV(LCD_DISPLAYMODE) | _BV(LCD_DISPLAYMODE_ON));
+		max7219_shutdown(0, 1);  // Power on
+	}
+	else {
+		lcd_command(_BV(LCD_DISPLAYMODE));
+		max7219_shutdown(0, 0);
+	}
+
+	#ifdef POWER_BACKLIGHT_PIN
+	if (on) {
+		POWER_BACKLIGHT_PORT |= (1 << POWER_BACKLIGHT_PIN);
+	}
+	else {
+		POWER_BACKLIGHT_PORT &= ~(1 << POWER_BACKLIGHT_PIN);
+	}
+	#endif
+}
+
+/**
+ * Function: Switches off the peripherals nothing uses. Call once at boot.
+ * Argument: None.
+ * Returns: None.
+ */
+void power_init(void) {
+	ADCSRA &= ~(1 << ADEN);  // The ADC has to be disabled before its clock is stopped
+	power_adc_disable();
+	power_twi_disable();
+	ACSR |= (1 << ACD);  // Analog comparator off
+	DIDR0 = (1 << ADC5D);  // PC5 is not connected, no input buffer needed
+
+	#ifdef POWER_BACKLIGHT_PIN
+	POWER_BACKLIGHT_DDR |= (1 << POWER_BACKLIGHT_PIN);
+	POWER_BACKLIGHT_PORT |= (1 << POWER_BACKLIGHT_PIN);
+	#endif
+
+	power_windowstart = sched_micros();
+	power_lastactivity = sched_millis();
+}
+
+/**
+ * Function: Sleeps until the next interrupt when no task is ready. Call from the main loop after sched_run().
+ * Argument: None.
+ * Returns: None.
+ */
+void power_idle(void) {
+	cli();
+	if (sched_pending()) {  // Checked with interrupts off, so a task made ready now can't be slept through
+		sei();
+		return;
+	}
+
+	uint32_t start = sched_micros();
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sleep_enable();
+	sei();
+	sleep_cpu();  // The instruction after sei() always executes, no interrupt can slip in between
+	sleep_disable();
+	power_slept += sched_micros() - start;
+}
+
+/**
+ * Function: Tells that someone is at the unit, wakes the displays when they are blanked.
+ * Argument: None.
+ * Returns: None.
+ */
+void power_activity(void) {
+	power_lastactivity = sched_millis();
+	if (power_blanked) {
+		power_blanked = 0;
+		power_displays(1);
+	}
+}
+
+/**
+ * Function: Returns the share of time spent asleep.
+ * Argument: None.
+ * Returns: per mille of the last POWER_POLL_MS window.
+ */
+uint16_t power_sleepratio(void) {
+	return power_ratio;
+}
+
+/**
+ * Function: Estimates the average supply current from the measured sleep time.
+ * Argument: POWER_DISPLAYS_ON, or POWER_DISPLAYS_BLANKED for the current with the displays blanked.
+ * Returns: Average current in microamps.
+ */
+uint32_t power_current(uint8_t mode) {
+	uint32_t cpu = ((uint32_t)POWER_CPU_ACTIVE_UA * (1000 - power_ratio) + (uint32_t)POWER_CPU_IDLE_UA * power_ratio) / 1000;
+	uint32_t displays = (mode == POWER_DISPLAYS_BLANKED) ? POWER_DISPLAYS_OFF_UA : POWER_DISPLAYS_ON_UA;
+
+	return cpu + displays + POWER_BOARD_UA;
+}
+
+/**
+ * Task: Measures the time spent asleep and blanks the displays when nobody is around.
+ * Runs every POWER_POLL_MS milliseconds.
+ */
+void power_task(void) {
+	uint32_t now = sched_micros();
+	uint32_t window = now - power_windowstart;
+
+	if (window >= 1000) {
+		uint32_t ratio = power_slept / (window / 1000);  // Stays within 32 bits for any window
+		power_ratio = (ratio > 1000) ? 1000 : ratio;
+	}
+	power_slept = 0;
+	power_windowstart = now;
+
+	#if POWER_BLANK_MS
+	if (!power_blanked && sched_millis() - power_lastactivity >= POWER_BLANK_MS) {
+		power_blanked = 1;
+		power_displays(0);
+	}
+	#endif
+}
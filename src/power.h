@@ -0,0 +1,57 @@
+/**
+ * Title:   	Power saving
+ *
+ * power_idle() is called from the main loop after sched_run(). When no task is ready
+ * it puts the CPU in SLEEP_MODE_IDLE until the next interrupt: the millisecond tick,
+ * a sensor edge, a received byte or the LCD queue. Deeper modes like SLEEP_MODE_PWR_SAVE
+ * stop timer 1, timer 0 and the UART, which keep the scheduler, the speaker and the
+ * command line going, so idle is the deepest mode that fits this design.
+ *
+ * power_init() switches off the ADC, TWI, analog comparator and unused input buffers.
+ * With POWER_BLANK_MS set, the LCD and the LED matrix are blanked when there was no
+ * alarm and no command for that long, they come back with the next one.
+ *
+ * The time spent asleep is measured, power_current() turns it into an average current
+ * with the estimates below. Replace them with measured values of the actual board.
+ */
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+
+#include "pins.h"
+
+//time without an alarm or a command after which the displays are blanked, 0 to never blank
+#define POWER_BLANK_MS 0
+
+//optional backlight switch, used when BOARD_BACKLIGHT is set in pins.h
+#ifdef BOARD_BACKLIGHT
+#define POWER_BACKLIGHT_DDR PIN_DDRREG(BOARD_BACKLIGHT)
+#define POWER_BACKLIGHT_PORT PIN_PORTREG(BOARD_BACKLIGHT)
+#define POWER_BACKLIGHT_PIN PIN_BIT(BOARD_BACKLIGHT)
+#endif
+
+//time between two runs of power_task(), also the window the sleep time is measured over
+#define POWER_POLL_MS 1000
+
+//estimated supply current in microamps at 16 MHz and 5 V
+#define POWER_CPU_ACTIVE_UA 9000		// running, from the datasheet
+#define POWER_CPU_IDLE_UA 2500			// in idle sleep with the unused peripherals off
+#define POWER_DISPLAYS_ON_UA 60000		// LCD with backlight, LED matrix at full intensity with a typical sprite
+#define POWER_DISPLAYS_OFF_UA 1700		// LCD off with the backlight switched off, LED matrix in shutdown
+#define POWER_BOARD_UA 5000				// regulator, USB serial chip and power LED of the board
+
+//modes for power_current()
+#define POWER_DISPLAYS_ON 0
+#define POWER_DISPLAYS_BLANKED 1
+
+//functions
+extern void power_init(void);
+extern void power_idle(void);
+extern void power_activity(void);
+extern uint16_t power_sleepratio(void);
+extern uint32_t power_current(uint8_t mode);
+extern void power_task(void);
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * Title:   	Profiling counters
+ *
+ * See profile.h for how the points are measured and reported.
+ */
+
+#include "profile.h"
+
+#if PROFILE
+
+#include <stdint.h>
+#include <avr/interrupt.h>
+
+#include "sched.h"
+#include "telemetry.h"
+
+static profile_t profile_points[PROFILE_POINTS];
+static uint8_t profile_overhead = 0;	// cycles of an empty measurement
+static uint8_t profile_next = 0;		// point reported next
+
+/**
+ * Function: Measures the cost of the timestamps and clears the counters. Call once at boot.
+ * Argument: None.
+ * Returns: None.
+ */
+void profile_init(void) {
+	uint32_t start = sched_cycles();
+	uint32_t overhead = sched_cycles() - start;
+
+	profile_overhead = (overhead > 255) ? 255 : overhead;
+	for (uint8_t i = 0; i < PROFILE_POINTS; i++) {
+		profile_points[i].calls = 0;
+		profile_points[i].total = 0;
+		profile_points[i].max = 0;
+	}
+}
+
+/**
+ * Function: Adds a measurement, also called from interrupts. Use PROFILE_END() instead.
+ * Arguments:
+ * 		1. Point.
+ * 		2. Timestamp taken by PROFILE_BEGIN().
+ * Returns: None.
+ */
+void profile_record(uint8_t point, uint32_t start) {
+	uint32_t cycles = sched_cycles() - start;
+	profile_t *stats = &profile_points[point];
+
+	cycles = (cycles > profile_overhead) ? cycles - profile_overhead : 0;
+
+	uint8_t sreg = SREG;
+	cli();
+	if (stats->calls < 0xFFFF) {
+		stats->calls++;
+	}
+	stats->total += cycles;
+	if (cycles > stats->max) {
+		stats->max = cycles;
+	}
+	SREG = sreg;
+}
+
+/**
+ * Function: Copies the counters of a point.
+ * Arguments:
+ * 		1. Point.
+ * 		2. Receives the counters.
+ * Returns: None.
+ */
+void profile_get(uint8_t point, profile_t *stats) {
+	uint8_t sreg = SREG;
+	cli();
+	*stats = profile_points[point];
+	SREG = sreg;
+}
+
+/**
+ * Task: Sends the counters of the next point and starts them over.
+ * Runs every PROFILE_REPORT_MS milliseconds.
+ */
+void profile_task(void) {
+	profile_t stats;
+
+	uint8_t sreg = SREG;
+	cli();
+	stats = profile_points[profile_next];
+	profile_points[profile_next].calls = 0;
+	profile_points[profile_next].total = 0;
+	profile_points[profile_next].max = 0;
+	SREG = sreg;
+
+	telemetry_profile(profile_next, stats.calls, stats.total, stats.max);
+	profile_next = (profile_next + 1) % PROFILE_POINTS;
+}
+
+#endif
@@ -0,0 +1,67 @@
+/**
+ * Title:   	Profiling counters
+ *
+ * Counts calls, total and worst-case CPU cycles of the hot paths, timed with timer 1:
+ * the scheduler tick runs it at the CPU clock, so every count is a cycle. The cost of
+ * taking the timestamps themselves is measured at start-up and taken off.
+ *
+ * Enable with PROFILE 1. profile_task() then sends one point per run as a telemetry
+ * record and starts its counters over, so every record covers the time since the
+ * previous record of that point. With PROFILE 0 the macros are empty and nothing of
+ * the profiler is built in, so both builds can be compared for size and timing.
+ */
+
+#ifndef PROFILE_H_
+#define PROFILE_H_
+
+#include <stdint.h>
+
+#include "sched.h"
+
+//1 to build in the profiling counters
+#ifndef PROFILE
+#define PROFILE 0
+#endif
+
+//measured points
+#define PROFILE_DHT_GETDATA 0		// blocking sensor reading
+#define PROFILE_DHT_POLL 1			// asynchronous sensor reader, decoding included
+#define PROFILE_DHT_EDGE 2			// pin change interrupt of the sensor line
+#define PROFILE_LCD_WRITE 3			// byte written to the LCD right away
+#define PROFILE_LCD_QUEUE 4			// timer 2 interrupt sending a queued LCD byte
+#define PROFILE_MAX7219_SEND 5		// register written to the LED driver
+#define PROFILE_CHECKSTATS 6		// handling of a new reading
+#define PROFILE_DISPLAY 7			// display task, redraws and page changes
+#define PROFILE_TICK 8				// timer 1 scheduler tick interrupt
+#define PROFILE_POINTS 9
+
+//time between two runs of profile_task(), every point is reported once every PROFILE_POINTS runs
+#define PROFILE_REPORT_MS 1000
+
+typedef struct {
+	uint16_t calls;
+	uint32_t total;		// cycles
+	uint32_t max;		// cycles of the longest call
+} profile_t;
+
+#if PROFILE
+
+//timestamp at the start of a measured block, a variable local to that block
+#define PROFILE_BEGIN(point) uint32_t profile_start_##point = sched_cycles()
+//end of the measured block, has to be reached from every PROFILE_BEGIN
+#define PROFILE_END(point) profile_record(point, profile_start_##point)
+
+//functions
+extern void profile_init(void);
+extern void profile_record(uint8_t point, uint32_t start);
+extern void profile_get(uint8_t point, profile_t *stats);
+extern void profile_task(void);
+
+#else
+
+#define PROFILE_BEGIN(point)
+#define PROFILE_END(point)
+
+#endif
+
+#endif
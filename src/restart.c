@@ -0,0 +1,148 @@
+/**
+ * Title:   	Watchdog and warm restart
+ *
+ * See restart.h for when a start is warm.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+#include <util/crc16.h>
+
+#include "restart.h"
+#include "sched.h"
+
+#if RESTART_TIMEOUT_MS < 2 * SCHED_MAXPERIOD
+#error "the watchdog timeout has to leave every task time for a period and its run"
+#endif
+
+//marks state sealed by the watchdog interrupt
+#define RESTART_MAGIC 0x5AFE
+
+typedef struct {
+	uint16_t magic;			// RESTART_MAGIC when the state is sealed
+	uint16_t crc;			// over all other .noinit bytes
+	uint8_t flags;			// MCUSR of this start
+	uint8_t warm;			// warm starts in a row
+	uint32_t since;			// millis of the last start
+} restart_state_t;
+
+static restart_state_t restart_state RESTART_NOINIT;
+
+#ifdef __AVR__
+
+// Linker symbols of avr-libc around the .noinit section
+extern uint8_t __noinit_start;
+extern uint8_t __noinit_end;
+
+void restart_boot(void) __attribute__((naked, used, section(".init3")));
+
+/**
+ * Function: Keeps the reset cause and stops the watchdog, which stays on after a watchdog
+ * reset with its shortest timeout. Runs from .init3, before the variables are initialised.
+ * Argument: None.
+ * Returns: None.
+ */
+void restart_boot(void) {
+	restart_state.flags = MCUSR;
+	MCUSR = 0;
+	wdt_disable();
+}
+
+/**
+ * Function: Calculates the CRC of the .noinit variables, restart_state left out.
+ * Argument: None.
+ * Returns: CRC-16.
+ */
+static uint16_t restart_crc(void) {
+	uint16_t crc = 0xFFFF;
+
+	for (const uint8_t *p = &__noinit_start; p < &__noinit_end; p++) {
+		if (p < (const uint8_t *)&restart_state || p >= (const uint8_t *)(&restart_state + 1)) {
+			crc = _crc16_update(crc, *p);
+		}
+	}
+	return crc;
+}
+
+/**
+ * Function: Sets all .noinit variables to 0, as they would be in .bss.
+ * Argument: None.
+ * Returns: None.
+ */
+static void restart_clear(void) {
+	memset(&__noinit_start, 0, &__noinit_end - &__noinit_start);
+}
+
+#else
+
+// On the host the .noinit variables are plain .bss and every start is cold
+static uint16_t restart_crc(void) {
+	return 0;
+}
+
+static void restart_clear(void) {
+}
+
+#endif
+
+/**
+ * Interupt triggered when the watchdog runs out, the scheduler stopped checking in.
+ * Seals the kept state for a warm start and resets right away.
+ */
+ISR(WDT_vect) {
+	if (sched_millis() - restart_state.since >= RESTART_STABLE_MS) {
+		restart_state.warm = 0;  // The warm start before worked for a while
+	}
+	if (restart_state.warm < RESTART_MAXWARM) {
+		restart_state.magic = RESTART_MAGIC;
+		restart_state.crc = restart_crc();
+	}
+
+	// Shortest timeout in reset mode, instead of waiting out another RESTART_TIMEOUT_MS
+	WDTCSR = (1 << WDCE) | (1 << WDE);
+	WDTCSR = (1 << WDE);
+	while (1) {
+	}
+}
+
+/**
+ * Function: Decides on a warm or cold start, call first thing at boot. A cold start clears the
+ * .noinit variables. The watchdog stays off until restart_enable().
+ * Argument: None.
+ * Returns: RESTART_WARM when the kept state can be used, RESTART_COLD otherwise.
+ */
+uint8_t restart_init(void) {
+	uint8_t flags = restart_state.flags;
+	uint8_t warm = (flags & (1 << WDRF)) && restart_state.magic == RESTART_MAGIC && restart_state.crc == restart_crc();
+
+	if (warm) {
+		warm = restart_state.warm + 1;
+	}
+	else {
+		restart_clear();
+	}
+	restart_state.magic = 0;  // Used once, a later reset has to seal again
+	restart_state.flags = flags;
+	restart_state.warm = warm;
+	restart_state.since = sched_millis();
+
+	return warm ? RESTART_WARM : RESTART_COLD;
+}
+
+/**
+ * Function: Starts the watchdog with RESTART_TIMEOUT_MS in interrupt and reset mode. Call
+ * once the tasks are registered, from then on they have to keep checking in.
+ * Argument: None.
+ * Returns: None.
+ */
+void restart_enable(void) {
+	uint8_t sreg = SREG;
+	cli();
+	wdt_reset();
+	WDTCSR = (1 << WDCE) | (1 << WDE);  // Timed sequence, the next write has to follow within 4 cycles
+	WDTCSR = (1 << WDIE) | (1 << WDE) | RESTART_PRESCALER;
+	SREG = sreg;
+}
@@ -0,0 +1,50 @@
+/**
+ * Title:   	Watchdog and warm restart
+ *
+ * The watchdog resets the MCU when the scheduler stops checking in: a task that hangs,
+ * like a reading stuck on the sensor bus, or a tick interrupt that no longer runs, see
+ * sched.h. The watchdog runs in interrupt and reset mode, so on a timeout its interrupt
+ * first seals the state kept in .noinit RAM with a CRC and then forces the reset.
+ *
+ * At boot restart_init() checks that seal. When it holds, the start is warm: the
+ * history, the sensors with their filters, alarms and extremes, the EEPROM checkpoint
+ * position and the millisecond clock are used as they were, and the LCD only needs
+ * lcd_restart(). Recovery then takes milliseconds and loses no readings. Any other
+ * start is cold: the .noinit variables are cleared like .bss, and the checkpoint in
+ * EEPROM is restored as after a power loss. That is also the case when an interrupt
+ * hung with interrupts off, so the watchdog interrupt could not seal the state.
+ *
+ * A fault that comes back within RESTART_STABLE_MS of a warm start may come from the
+ * kept state itself, after RESTART_MAXWARM such starts in a row the next one is cold.
+ */
+
+#ifndef RESTART_H_
+#define RESTART_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+//variables that a warm start keeps, they may not have an initializer
+#ifdef __AVR__
+#define RESTART_NOINIT __attribute__((section(".noinit")))
+#else
+#define RESTART_NOINIT
+#endif
+
+//watchdog timeout, every task has to check in within it
+#define RESTART_TIMEOUT_MS 2000
+#define RESTART_PRESCALER ((1 << WDP2) | (1 << WDP1) | (1 << WDP0))	// 2 s, has to match the timeout
+
+//warm starts in a row, each within the stable time of the one before, after which the state is dropped
+#define RESTART_MAXWARM 3
+#define RESTART_STABLE_MS 60000UL
+
+//kinds of start
+#define RESTART_COLD 0
+#define RESTART_WARM 1
+
+//functions
+extern uint8_t restart_init(void);
+extern void restart_enable(void);
+
+#endif
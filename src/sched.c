@@ -0,0 +1,243 @@
+/**
+ * Title:   	Cooperative task scheduler
+ *
+ * See sched.h for an explanation of the scheduling model.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/wdt.h>
+
+#include "sched.h"
+#include "profile.h"
+#include "restart.h"
+
+static sched_task_t sched_tasks[SCHED_MAXTASKS];
+static uint8_t sched_count = 0;
+static uint8_t sched_checkins = 0;			// one bit per task that ran since the watchdog was last reset
+static volatile uint32_t sched_ticks RESTART_NOINIT;	// kept over a warm restart, so saved times stay valid
+
+/**
+ * Interupt triggered every millisecond by the compare match of timer 1A.
+ * Only advances the tick and flags the tasks whose period elapsed.
+ */
+ISR(TIMER1_COMPA_vect) {
+	sched_ticks++;
+	PROFILE_BEGIN(PROFILE_TICK);  // After the increment, the counter already started over
+
+	for(uint8_t i = 0; i < sched_count; i++) {
+		if (--sched_tasks[i].countdown == 0) {
+			sched_tasks[i].countdown = sched_tasks[i].period;
+			sched_tasks[i].ready = 1;
+		}
+	}
+	PROFILE_END(PROFILE_TICK);
+}
+
+/**
+ * Function: Sets up timer 1 to generate the millisecond tick. Interrupts still have to be enabled by the caller.
+ * Argument: None.
+ * Returns: None.
+ */
+void sched_init(void) {
+	TCCR1A = 0;
+	TCCR1B = (1 << WGM12) | SCHED_CLOCKSELECT;  // CTC mode with OCR1A as top
+	OCR1A = SCHED_COUNTSPERMS - 1;
+	TCNT1 = 0;
+	TIMSK1 |= (1 << OCIE1A);  // Compare match interrupt enabled
+}
+
+/**
+ * Function: Registers a new task. The first run happens one period after registering.
+ * Arguments:
+ * 		1. Function to execute.
+ * 		2. Period in milliseconds, 1 up to SCHED_MAXPERIOD.
+ * 		3. Run-time budget in microseconds, runs exceeding it are counted as overrun.
+ * Returns: task id, or -1 when no more tasks fit or the period is out of range.
+ */
+int8_t sched_add(sched_taskfn_t fn, uint16_t period, uint16_t budget) {
+	if (sched_count >= SCHED_MAXTASKS || period == 0 || period > SCHED_MAXPERIOD) {
+		return -1;
+	}
+
+	sched_task_t *task = &sched_tasks[sched_count];
+	task->fn = fn;
+	task->period = period;
+	task->countdown = period;
+	task->ready = 0;
+	task->budget = budget;
+	task->maxrun = 0;
+	task->overruns = 0;
+
+	// Only make the task visible to the tick interrupt once it is complete
+	uint8_t sreg = SREG;
+	cli();
+	sched_count++;
+	SREG = sreg;
+
+	return sched_count - 1;
+}
+
+/**
+ * Function: Changes the period of a task, takes effect after the current period ended.
+ * Arguments:
+ * 		1. Task id.
+ * 		2. New period in milliseconds, 1 up to SCHED_MAXPERIOD.
+ * Returns: None.
+ */
+void sched_setperiod(uint8_t id, uint16_t period) {
+	if (id < sched_count && period != 0 && period <= SCHED_MAXPERIOD) {
+		uint8_t sreg = SREG;
+		cli();
+		sched_tasks[id].period = period;  // The tick interrupt reloads the countdown from it, both bytes at once
+		SREG = sreg;
+	}
+}
+
+/**
+ * Function: Makes a task ready right away and restarts its period.
+ * Argument: Task id.
+ * Returns: None.
+ */
+void sched_trigger(uint8_t id) {
+	if (id < sched_count) {
+		uint8_t sreg = SREG;
+		cli();
+		sched_tasks[id].countdown = sched_tasks[id].period;
+		sched_tasks[id].ready = 1;
+		SREG = sreg;
+	}
+}
+
+/**
+ * Function: Runs every ready task once and keeps track of its run-time, resets the watchdog once
+ * every task checked in. Call this from the main loop.
+ * Argument: None.
+ * Returns: None.
+ */
+void sched_run(void) {
+	for(uint8_t i = 0; i < sched_count; i++) {
+		sched_task_t *task = &sched_tasks[i];
+
+		if (task->ready) {
+			task->ready = 0;
+
+			uint32_t start = sched_micros();
+			task->fn();
+			uint32_t runtime = sched_micros() - start;
+
+			if (runtime > 0xFFFF) {  // Clamp so extreme runs still show up as worst-case
+				runtime = 0xFFFF;
+			}
+			if (runtime > task->maxrun) {
+				task->maxrun = runtime;
+			}
+			if (runtime > task->budget) {
+				task->overruns++;
+			}
+			sched_checkins |= (1 << i);
+		}
+	}
+
+	if (sched_count != 0 && sched_checkins == (uint8_t)((1 << sched_count) - 1)) {
+		wdt_reset();
+		sched_checkins = 0;
+	}
+}
+
+/**
+ * Function: Tells if a task is waiting to run. Call with interrupts disabled to decide on sleeping without a race.
+ * Argument: None.
+ * Returns: 1 when a task is ready, 0 otherwise.
+ */
+uint8_t sched_pending(void) {
+	for(uint8_t i = 0; i < sched_count; i++) {
+		if (sched_tasks[i].ready) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Function: Returns the milliseconds passed since the cold start, a warm restart keeps counting.
+ * Argument: None.
+ * Returns: milliseconds as unsigned 32 bit integer.
+ */
+uint32_t sched_millis(void) {
+	uint32_t ticks;
+
+	uint8_t sreg = SREG;
+	cli();
+	ticks = sched_ticks;
+	SREG = sreg;
+
+	return ticks;
+}
+
+/**
+ * Function: Returns the microseconds passed since sched_init(), with the resolution of timer 1.
+ * Argument: None.
+ * Returns: microseconds as unsigned 32 bit integer, wraps after about 71 minutes.
+ */
+uint32_t sched_micros(void) {
+	uint32_t ticks;
+	uint16_t count;
+
+	uint8_t sreg = SREG;
+	cli();
+	ticks = sched_ticks;
+	count = TCNT1;
+	// A compare match that is not handled yet still belongs to the current reading
+	if ((TIFR1 & (1 << OCF1A)) && count < (SCHED_COUNTSPERMS / 2)) {
+		ticks++;
+	}
+	SREG = sreg;
+
+	return ticks * 1000 + count / SCHED_COUNTSPERUS;
+}
+
+/**
+ * Function: Returns the CPU cycles passed since sched_init(), with the resolution of timer 1.
+ * Argument: None.
+ * Returns: cycles as unsigned 32 bit integer, wraps after about 268 seconds at 16 MHz.
+ */
+uint32_t sched_cycles(void) {
+	uint32_t ticks;
+	uint16_t count;
+
+	uint8_t sreg = SREG;
+	cli();
+	ticks = sched_ticks;
+	count = TCNT1;
+	if ((TIFR1 & (1 << OCF1A)) && count < (SCHED_COUNTSPERMS / 2)) {
+		ticks++;
+	}
+	SREG = sreg;
+
+	return (ticks * SCHED_COUNTSPERMS + count) * SCHED_PRESCALER;
+}
+
+/**
+ * Function: Returns the worst-case run-time a task has had.
+ * Argument: Task id.
+ * Returns: run-time in microseconds.
+ */
+uint16_t sched_maxrun(uint8_t id) {
+	if (id < sched_count) {
+		return sched_tasks[id].maxrun;
+	}
+	return 0;
+}
+
+/**
+ * Function: Returns how many runs of a task exceeded its budget.
+ * Argument: Task id.
+ * Returns: amount of overruns.
+ */
+uint16_t sched_overruns(uint8_t id) {
+	if (id < sched_count) {
+		return sched_tasks[id].overruns;
+	}
+	return 0;
+}
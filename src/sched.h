@@ -0,0 +1,60 @@
+/**
+ * Title:   	Cooperative task scheduler
+ *
+ * Timer 1 runs in CTC mode and only advances a millisecond tick counter.
+ * Every tick the interrupt counts down each registered task and flags it ready
+ * when its period elapsed. The main loop calls sched_run(), which executes the
+ * ready tasks one after another and records their worst-case run-time.
+ * Tasks must be short state machines: they may never busy-wait.
+ *
+ * A task checks in by returning from its run. Once every registered task ran since
+ * the last round, sched_run() resets the watchdog. A task that hangs, or a tick that
+ * stopped so no task gets ready, lets the watchdog run out, see restart.h.
+ */
+
+#ifndef SCHED_H_
+#define SCHED_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "pins.h"
+
+//maximum number of tasks that can be registered, one check-in bit each
+#define SCHED_MAXTASKS 8
+
+//longest task period, every task has to check in within the watchdog timeout
+#define SCHED_MAXPERIOD 1000
+
+//timer 1 runs at the CPU clock, so one count equals one cycle and 1/16 us at 16 MHz
+#define SCHED_PRESCALER 1
+#define SCHED_CLOCKSELECT (1 << CS10)
+#define SCHED_COUNTSPERMS (F_CPU / SCHED_PRESCALER / 1000)
+#define SCHED_COUNTSPERUS (F_CPU / SCHED_PRESCALER / 1000000)
+
+typedef void (*sched_taskfn_t)(void);
+
+typedef struct {
+	sched_taskfn_t fn;			// function executed when the task is ready
+	uint16_t period;			// time in milliseconds between two runs
+	volatile uint16_t countdown;	// milliseconds left until next run, decreased by the tick interrupt
+	volatile uint8_t ready;		// set by the tick interrupt, cleared when the task runs
+	uint16_t budget;			// allowed run-time in microseconds
+	uint16_t maxrun;			// worst-case measured run-time in microseconds
+	uint16_t overruns;			// amount of runs that exceeded the budget
+} sched_task_t;
+
+//functions
+extern void sched_init(void);
+extern int8_t sched_add(sched_taskfn_t fn, uint16_t period, uint16_t budget);
+extern void sched_setperiod(uint8_t id, uint16_t period);
+extern void sched_trigger(uint8_t id);
+extern void sched_run(void);
+extern uint8_t sched_pending(void);
+extern uint32_t sched_millis(void);
+extern uint32_t sched_micros(void);
+extern uint32_t sched_cycles(void);
+extern uint16_t sched_maxrun(uint8_t id);
+extern uint16_t sched_overruns(uint8_t id);
+
+#endif
@@ -0,0 +1,135 @@
+/**
+ * Title:   	Sensors
+ *
+ * See sensor.h for how the sensors are read.
+ */
+
+#include <stdint.h>
+
+#include "sensor.h"
+#include "sched.h"
+#include "restart.h"
+
+#if SENSOR_COUNT < 1 || SENSOR_COUNT > 8
+#error SENSOR_COUNT must be 1 up to 8, the sensors share the lines of one port.
+#endif
+
+static const uint8_t sensor_list[SENSOR_COUNT][2] = SENSOR_LIST;	// pin and type of every sensor
+
+sensor_t sensors[SENSOR_COUNT] RESTART_NOINIT;	// kept over a warm restart, see restart.h
+
+static uint16_t sensor_interval = DHT_SAMPLEMS;	// time between two readings of a sensor
+static uint8_t sensor_current = SENSOR_COUNT - 1;	// sensor read last, the next one is tried first
+
+/**
+ * Function: Checks if a sensor is due for a reading.
+ * Arguments:
+ * 		1. Sensor.
+ * 		2. Current millis.
+ * Returns: 1 when the sampling interval of the sensor passed, 0 otherwise.
+ */
+static uint8_t sensor_due(const sensor_t *sensor, uint32_t now) {
+	uint16_t interval = sensor_interval;
+	uint16_t fastest = (sensor->type == DHT_DHT11) ? DHT_DHT11_SAMPLEMS : DHT_DHT22_SAMPLEMS;
+
+	if (interval < fastest) {
+		interval = fastest;
+	}
+	return !sensor->sampled || now - sensor->sampletime >= interval;
+}
+
+/**
+ * Function: Sets the pins and types of SENSOR_LIST, idles the sensor lines and sets up the asynchronous reader.
+ * The readings, filters and alarms are left as they are, so they can be kept over a warm restart.
+ * Argument: None.
+ * Returns: None.
+ */
+void sensor_init(void) {
+	uint8_t pins = 0;
+
+	for (uint8_t i = 0; i < SENSOR_COUNT; i++) {
+		sensors[i].pin = sensor_list[i][0];
+		sensors[i].type = sensor_list[i][1];
+		pins |= (1 << sensors[i].pin);
+		sensors[i].sampled = 0;
+		sensors[i].fresh = 0;
+		sensors[i].failed = 0;
+	}
+	dht_init(pins);
+}
+
+/**
+ * Function: Sets the time between two readings of a sensor, sensors that can't go this fast are read slower.
+ * Argument: Time in milliseconds.
+ * Returns: None.
+ */
+void sensor_setinterval(uint16_t ms) {
+	sensor_interval = ms;
+}
+
+/**
+ * Function: Advances the readings, starts the next sensor that is due once the reader is idle. Call every millisecond.
+ * Argument: Receives the sensor a DHT_READY or DHT_ERROR belongs to.
+ * Returns: The status of dht_poll(). On DHT_READY the reading is stored in the sensor, marked fresh.
+ */
+int8_t sensor_sample(uint8_t *sensor) {
+	int8_t status = dht_poll();
+
+	if (status == DHT_READY || status == DHT_ERROR) {
+		sensor_t *read = &sensors[sensor_current];
+
+		*sensor = sensor_current;
+		if (status == DHT_READY && dht_getresult(&read->temperature, &read->humidity) == 0) {
+			read->fresh = 1;
+		}
+		return status;
+	}
+
+	if (status == DHT_IDLE) {
+		uint32_t now = sched_millis();
+
+		// Round-robin, the sensor after the one read last goes first
+		for (uint8_t i = 1; i <= SENSOR_COUNT; i++) {
+			uint8_t next = (sensor_current + i) % SENSOR_COUNT;
+			sensor_t *candidate = &sensors[next];
+
+			if (sensor_due(candidate, now)) {
+				candidate->sampletime = now;
+				candidate->sampled = 1;
+				sensor_current = next;
+				dht_start(candidate->pin, candidate->type);
+				return DHT_BUSY;
+			}
+		}
+	}
+	return status;
+}
+
+/**
+ * Function: Gets the last reading of a sensor that the filters accepted.
+ * Arguments:
+ * 		1. Sensor.
+ * 		2. Receives the temperature.
+ * 		3. Receives the humidity.
+ * Returns: 0, or -1 when the sensor has no accepted reading yet.
+ */
+int8_t sensor_getreading(uint8_t sensor, dht_value_t *temperature, dht_value_t *humidity) {
+	if (sensor >= SENSOR_COUNT || !sensors[sensor].valid) {
+		return -1;
+	}
+	*temperature = sensors[sensor].temperature_previous;
+	*humidity = sensors[sensor].humidity_previous;
+	return 0;
+}
+
+/**
+ * Function: Gets the age of the last reading of a sensor that the filters accepted.
+ * Argument: Sensor.
+ * Returns: Milliseconds since it was accepted, SENSOR_NOAGE when the sensor has none yet.
+ */
+uint32_t sensor_getage(uint8_t sensor) {
+	if (sensor >= SENSOR_COUNT || !sensors[sensor].valid) {
+		return SENSOR_NOAGE;
+	}
+	return sched_millis() - sensors[sensor].validtime;
+}
@@ -0,0 +1,80 @@
+/**
+ * Title:   	Sensors
+ *
+ * Describes the DHT11 and DHT22 sensors of SENSOR_LIST, each on its own line of
+ * DHT_PORT, and keeps the state of every sensor next to its pin and type: the last
+ * reading, the filters, the alarms and the extremes.
+ *
+ * sensor_sample() reads the sensors in turn with the asynchronous DHT reader, so a
+ * reading never blocks and N sensors take N readings of about 22 ms, not N blocking
+ * reads. Every sensor is read at most once per sampling interval, and never faster
+ * than its type allows. A finished reading is stored in its sensor_t and marked fresh.
+ *
+ * The last reading the filters accepted is kept with the time it was accepted, so
+ * sensor_getreading() and sensor_getage() answer without a bus transaction.
+ *
+ * Every sensor takes HISTORY_SIZE * 2 bytes of SRAM and of EEPROM for its history,
+ * with the 24 hour history two sensors fit the ATmega328.
+ */
+
+#ifndef SENSOR_H_
+#define SENSOR_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "dht.h"
+#include "filter.h"
+#include "alarm.h"
+
+//sensors, the pin on DHT_PORT and the type of every one, set DHT_TYPE to DHT_DHT22 for DHT22 tenths
+#define SENSOR_COUNT 1
+#define SENSOR_LIST {{PIN_BIT(BOARD_DHT1), DHT_DHT11}}
+//#define SENSOR_COUNT 2
+//#define SENSOR_LIST {{PIN_BIT(BOARD_DHT1), DHT_DHT11}, {PIN_BIT(BOARD_DHT2), DHT_DHT22}}
+
+typedef struct {
+	// descriptor
+	uint8_t pin;				// on DHT_PORT
+	uint8_t type;				// DHT_DHT11 or DHT_DHT22
+
+	// reading, in the unit of the DHT library
+	uint8_t fresh;				// a new reading is waiting to be handled
+	uint8_t valid;				// a reading was accepted since the start
+	uint8_t failed;				// the last reading failed
+	dht_value_t temperature;
+	dht_value_t humidity;
+	dht_value_t temperature_previous;	// last accepted values, shown instead of a rejected reading
+	dht_value_t humidity_previous;
+	uint32_t validtime;			// millis the last accepted reading was accepted
+	filter_t temperature_filter;
+	filter_t humidity_filter;
+
+	// alarms and extremes
+	alarm_t temperature_alarm;
+	alarm_t humidity_alarm;
+	int8_t temperature_dir;		// direction the limits are exceeded in, ALARM_ state
+	int8_t humidity_dir;
+	dht_value_t temperature_max;
+	dht_value_t temperature_min;
+	dht_value_t humidity_max;
+	dht_value_t humidity_min;
+
+	// sampling
+	uint8_t sampled;			// a reading was started at least once
+	uint32_t sampletime;		// millis the last reading started
+} sensor_t;
+
+//age of a sensor without an accepted reading
+#define SENSOR_NOAGE 0xFFFFFFFF
+
+extern sensor_t sensors[SENSOR_COUNT];
+
+//functions
+extern void sensor_init(void);
+extern void sensor_setinterval(uint16_t ms);
+extern int8_t sensor_sample(uint8_t *sensor);
+extern int8_t sensor_getreading(uint8_t sensor, dht_value_t *temperature, dht_value_t *humidity);
+extern uint32_t sensor_getage(uint8_t sensor);
+
+#endif
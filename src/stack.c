@@ -0,0 +1,80 @@
+/**
+ * Title:   	RAM usage
+ *
+ * See stack.h.
+ */
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "stack.h"
+
+#ifdef __AVR__
+
+// Linker symbols of avr-libc: start of .data, end of .bss and .noinit
+extern uint8_t __data_start;
+extern uint8_t _end;
+
+void stack_paint(void) __attribute__((naked, used, section(".init3")));
+
+/**
+ * Function: Fills the free RAM with STACK_PAINT. Runs from .init3, after the stack pointer
+ * is set and before the variables are initialised, nothing is on the stack yet.
+ * Argument: None.
+ * Returns: None.
+ */
+void stack_paint(void) {
+	uint8_t *p = &_end;
+
+	while (p <= (uint8_t *)RAMEND) {
+		*p++ = STACK_PAINT;
+	}
+}
+
+/**
+ * Function: Gives the RAM taken by the variables.
+ * Argument: None.
+ * Returns: Bytes of .data, .bss and .noinit.
+ */
+uint16_t stack_static(void) {
+	return (uint16_t)(&_end - &__data_start);
+}
+
+/**
+ * Function: Counts the painted bytes the stack never reached.
+ * Argument: None.
+ * Returns: Bytes between the variables and the deepest point of the stack so far.
+ */
+uint16_t stack_unused(void) {
+	const uint8_t *p = &_end;
+
+	while (p <= (const uint8_t *)RAMEND && *p == STACK_PAINT) {
+		p++;
+	}
+	return (uint16_t)(p - &_end);
+}
+
+/**
+ * Function: Gives the high-water mark of the stack.
+ * Argument: None.
+ * Returns: Most bytes the stack took since the reset.
+ */
+uint16_t stack_peak(void) {
+	return (uint16_t)((const uint8_t *)RAMEND + 1 - &_end) - stack_unused();
+}
+
+#else
+
+uint16_t stack_static(void) {
+	return 0;
+}
+
+uint16_t stack_peak(void) {
+	return 0;
+}
+
+uint16_t stack_unused(void) {
+	return 0;
+}
+
+#endif
@@ -0,0 +1,30 @@
+/**
+ * Title:   	RAM usage
+ *
+ * Measures how much of the RAM is taken. The variables of .data, .bss and .noinit are
+ * fixed at link time, the build prints their size after every firmware build, see
+ * scripts/size_report.py. The rest of the RAM is left to the stack, nothing is taken
+ * with malloc.
+ *
+ * Before main() runs, the free RAM between the variables and the stack is filled with
+ * STACK_PAINT. The stack overwrites the pattern as it grows, so the painted bytes that
+ * are left above the variables show how deep it went at most: the high-water mark. A
+ * peak close to the free RAM means the next buffer or history sample will not fit.
+ *
+ * On the host there is no linker layout to measure, every function returns 0.
+ */
+
+#ifndef STACK_H_
+#define STACK_H_
+
+#include <stdint.h>
+
+//value of the free RAM before the stack reaches it, unlikely to be pushed by the firmware
+#define STACK_PAINT 0xC5
+
+//functions
+extern uint16_t stack_static(void);
+extern uint16_t stack_peak(void);
+extern uint16_t stack_unused(void);
+
+#endif
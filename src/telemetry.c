@@ -0,0 +1,248 @@
+/**
+ * Title:   	Serial telemetry
+ *
+ * See telemetry.h for the record formats.
+ */
+
+#include <stdint.h>
+#include <util/crc16.h>
+
+#include "telemetry.h"
+#include "uart.h"
+#include "format.h"
+#include "sched.h"
+
+//longest payload of a binary frame, and longest CSV line
+#define TELEMETRY_MAXPAYLOAD 14
+#define TELEMETRY_MAXLINE 48
+
+static uint8_t telemetry_format = TELEMETRY_FORMAT;
+static uint8_t telemetry_sequence = 0;
+static uint16_t telemetry_lost = 0;
+
+/**
+ * Function: Sends a binary frame.
+ * Arguments:
+ * 		1. Frame type.
+ * 		2. Payload.
+ * 		3. Payload length, at most TELEMETRY_MAXPAYLOAD.
+ * Returns: None.
+ */
+static void telemetry_frame(uint8_t type, const uint8_t *payload, uint8_t length) {
+	uint8_t frame[TELEMETRY_MAXPAYLOAD + 4];
+	uint8_t crc = 0;
+
+	frame[0] = TELEMETRY_SYNC;
+	frame[1] = type;
+	frame[2] = length;
+	for (uint8_t i = 0; i < length; i++) {
+		frame[3 + i] = payload[i];
+	}
+	for (uint8_t i = 1; i < length + 3; i++) {
+		crc = _crc_ibutton_update(crc, frame[i]);
+	}
+	frame[3 + length] = crc;
+
+	if (uart_write(frame, length + 4) != 0) {
+		telemetry_lost++;
+	}
+}
+
+/**
+ * Function: Sends a CSV line with the values of a sensor.
+ * Arguments:
+ * 		1. Record letter.
+ * 		2. Seconds since the start.
+ * 		3. First value.
+ * 		4. Second value.
+ * 		5. Digits after the decimal point of the values.
+ * 		6. Sensor.
+ * Returns: None.
+ */
+static void telemetry_line(char record, uint16_t seconds, int16_t first, int16_t second, uint8_t decimals, uint8_t sensor) {
+	char line[TELEMETRY_MAXLINE];
+	uint8_t position = 0;
+
+	line[position++] = record;
+	line[position++] = ',';
+	position += format_number(line + position, telemetry_sequence, 0);
+	line[position++] = ',';
+	position += format_number(line + position, seconds, 0);
+	line[position++] = ',';
+	position += format_number(line + position, first, decimals);
+	line[position++] = ',';
+	position += format_number(line + position, second, decimals);
+	line[position++] = ',';
+	position += format_number(line + position, sensor, 0);
+	line[position++] = '\r';
+	line[position++] = '\n';
+
+	if (uart_write((const uint8_t *)line, position) != 0) {
+		telemetry_lost++;
+	}
+}
+
+/**
+ * Function: Returns the timestamp of a record.
+ * Argument: None.
+ * Returns: seconds since the start, wraps around after about 18 hours.
+ */
+static uint16_t telemetry_seconds(void) {
+	return sched_millis() / 1000;
+}
+
+/**
+ * Function: Sets up the UART and selects the TELEMETRY_FORMAT format.
+ * Argument: None.
+ * Returns: None.
+ */
+void telemetry_init(void) {
+	uart_init();
+	telemetry_format = TELEMETRY_FORMAT;
+}
+
+/**
+ * Function: Selects the record format.
+ * Argument: TELEMETRY_OFF, TELEMETRY_BINARY or TELEMETRY_CSV.
+ * Returns: None.
+ */
+void telemetry_setformat(uint8_t format) {
+	if (format <= TELEMETRY_CSV) {
+		telemetry_format = format;
+	}
+}
+
+/**
+ * Function: Returns the selected record format.
+ * Argument: None.
+ * Returns: TELEMETRY_OFF, TELEMETRY_BINARY or TELEMETRY_CSV.
+ */
+uint8_t telemetry_getformat(void) {
+	return telemetry_format;
+}
+
+/**
+ * Function: Sends a validated reading.
+ * Arguments:
+ * 		1. Sensor.
+ * 		2. Temperature in units of 10^-decimals degrees Celcius.
+ * 		3. Humidity in units of 10^-decimals percent.
+ * 		4. Digits after the decimal point.
+ * Returns: None.
+ */
+void telemetry_reading(uint8_t sensor, int16_t temperature, int16_t humidity, uint8_t decimals) {
+	uint16_t seconds = telemetry_seconds();
+
+	if (telemetry_format == TELEMETRY_BINARY) {
+		uint8_t payload[9] = {
+			telemetry_sequence,
+			seconds & 0xFF, seconds >> 8,
+			decimals,
+			temperature & 0xFF, (uint16_t)temperature >> 8,
+			humidity & 0xFF, (uint16_t)humidity >> 8,
+			sensor
+		};
+		telemetry_frame(TELEMETRY_READING, payload, sizeof(payload));
+	}
+	else if (telemetry_format == TELEMETRY_CSV) {
+		telemetry_line('R', seconds, temperature, humidity, decimals, sensor);
+	}
+	else {
+		return;
+	}
+	telemetry_sequence++;
+}
+
+/**
+ * Function: Sends a change of the alarm state.
+ * Arguments:
+ * 		1. Sensor.
+ * 		2. Direction the temperature exceeds its limits: 1 above, -1 below, 0 within.
+ * 		3. Idem for the humidity.
+ * Returns: None.
+ */
+void telemetry_alarm(uint8_t sensor, int8_t temperature_dir, int8_t humidity_dir) {
+	uint16_t seconds = telemetry_seconds();
+
+	if (telemetry_format == TELEMETRY_BINARY) {
+		uint8_t payload[6] = {
+			telemetry_sequence,
+			seconds & 0xFF, seconds >> 8,
+			temperature_dir,
+			humidity_dir,
+			sensor
+		};
+		telemetry_frame(TELEMETRY_ALARM, payload, sizeof(payload));
+	}
+	else if (telemetry_format == TELEMETRY_CSV) {
+		telemetry_line('A', seconds, temperature_dir, humidity_dir, 0, sensor);
+	}
+	else {
+		return;
+	}
+	telemetry_sequence++;
+}
+
+#if PROFILE
+/**
+ * Function: Sends the counters of a profiling point.
+ * Arguments:
+ * 		1. Point, PROFILE_ number.
+ * 		2. Calls since the previous record.
+ * 		3. Total cycles of those calls.
+ * 		4. Cycles of the longest call.
+ * Returns: None.
+ */
+void telemetry_profile(uint8_t point, uint16_t calls, uint32_t total, uint32_t max) {
+	uint16_t seconds = telemetry_seconds();
+
+	if (telemetry_format == TELEMETRY_BINARY) {
+		uint8_t payload[14] = {
+			telemetry_sequence,
+			seconds & 0xFF, seconds >> 8,
+			point,
+			calls & 0xFF, calls >> 8,
+			total & 0xFF, (total >> 8) & 0xFF, (total >> 16) & 0xFF, total >> 24,
+			max & 0xFF, (max >> 8) & 0xFF, (max >> 16) & 0xFF, max >> 24
+		};
+		telemetry_frame(TELEMETRY_PROFILE, payload, sizeof(payload));
+	}
+	else if (telemetry_format == TELEMETRY_CSV) {
+		char line[TELEMETRY_MAXLINE];
+		uint8_t position = 0;
+
+		line[position++] = 'P';
+		line[position++] = ',';
+		position += format_number(line + position, telemetry_sequence, 0);
+		line[position++] = ',';
+		position += format_number(line + position, seconds, 0);
+		line[position++] = ',';
+		position += format_number(line + position, point, 0);
+		line[position++] = ',';
+		position += format_number(line + position, calls, 0);
+		line[position++] = ',';
+		position += format_number(line + position, (total > INT32_MAX) ? INT32_MAX : total, 0);
+		line[position++] = ',';
+		position += format_number(line + position, (max > INT32_MAX) ? INT32_MAX : max, 0);
+		line[position++] = '\r';
+		line[position++] = '\n';
+
+		if (uart_write((const uint8_t *)line, position) != 0) {
+			telemetry_lost++;
+		}
+	}
+	else {
+		return;
+	}
+	telemetry_sequence++;
+}
+#endif
+
+/**
+ * Function: Returns how many records were dropped because the transmit ring was full.
+ * Argument: None.
+ * Returns: amount of records.
+ */
+uint16_t telemetry_dropped(void) {
+	return telemetry_lost;
+}
@@ -0,0 +1,55 @@
+/**
+ * Title:   	Serial telemetry
+ *
+ * Streams every validated reading and every change of the alarm state over the UART.
+ *
+ * The binary format sends frames of
+ * 		TELEMETRY_SYNC, type, payload length, payload, CRC-8
+ * with the CRC (Dallas/Maxim polynomial) over type, length and payload. Multi-byte values
+ * are little endian, seconds count from the start and wrap around. The CSV format sends
+ * one line per record instead:
+ * 		R,<sequence>,<seconds>,<temperature>,<humidity>,<sensor>
+ * 		A,<sequence>,<seconds>,<temperature direction>,<humidity direction>,<sensor>
+ * 		P,<sequence>,<seconds>,<point>,<calls>,<total cycles>,<max cycles>
+ * with the readings in whole units or with one decimal, like the DHT library returns them.
+ * The sensor number, the position in SENSOR_LIST, comes last so older readers keep working.
+ *
+ * A record that does not fit in the transmit ring is dropped as a whole, the sequence
+ * number shows the gap at the receiving end.
+ */
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+
+#include "profile.h"
+
+//formats
+#define TELEMETRY_OFF 0
+#define TELEMETRY_BINARY 1
+#define TELEMETRY_CSV 2
+
+//format after telemetry_init()
+#define TELEMETRY_FORMAT TELEMETRY_BINARY
+
+//first byte of a binary frame
+#define TELEMETRY_SYNC 0xA5
+
+//binary frame types
+#define TELEMETRY_READING 0x01		// uint8 sequence, uint16 seconds, uint8 decimals, int16 temperature, int16 humidity, uint8 sensor
+#define TELEMETRY_ALARM 0x02		// uint8 sequence, uint16 seconds, int8 temperature direction, int8 humidity direction, uint8 sensor
+#define TELEMETRY_PROFILE 0x03		// uint8 sequence, uint16 seconds, uint8 point, uint16 calls, uint32 total cycles, uint32 max cycles, see profile.h
+
+//functions
+extern void telemetry_init(void);
+extern void telemetry_setformat(uint8_t format);
+extern uint8_t telemetry_getformat(void);
+extern void telemetry_reading(uint8_t sensor, int16_t temperature, int16_t humidity, uint8_t decimals);
+extern void telemetry_alarm(uint8_t sensor, int8_t temperature_dir, int8_t humidity_dir);
+extern uint16_t telemetry_dropped(void);
+#if PROFILE
+extern void telemetry_profile(uint8_t point, uint16_t calls, uint32_t total, uint32_t max);
+#endif
+
+#endif
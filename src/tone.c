@@ -0,0 +1,116 @@
+/**
+ * Title:   	Tone generator
+ *
+ * See tone.h for an explanation of how tones are generated.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "tone.h"
+
+static volatile uint32_t tone_toggles = 0;  // half periods left, 0 plays until tone_stop()
+static volatile uint8_t tone_active = 0;
+
+// Timer 0 prescalers with their clock select bits, from fine to coarse
+static const uint16_t tone_prescalers[] = {1, 8, 64, 256, 1024};
+static const uint8_t tone_clockselect[] = {
+	(1 << CS00),
+	(1 << CS01),
+	(1 << CS01) | (1 << CS00),
+	(1 << CS02),
+	(1 << CS02) | (1 << CS00)
+};
+
+/**
+ * Interupt triggered by every compare match of timer 0A, which is every toggle of the tone pin.
+ */
+ISR(TIMER0_COMPA_vect) {
+	if (tone_toggles > 0 && --tone_toggles == 0) {
+		tone_stop();
+	}
+}
+
+/**
+ * Function: Sets up the tone pin, silent.
+ * Argument: None.
+ * Returns: None.
+ */
+void tone_init(void) {
+	TONE_DDR |= (1 << TONE_PIN);
+	TONE_PORT &= ~(1 << TONE_PIN);
+	tone_stop();
+}
+
+/**
+ * Function: Starts playing a tone, replacing the one that is playing. Returns right away.
+ * Arguments:
+ * 		1. Frequency in Hz, from 31 Hz up to TONE_MAXHZ.
+ * 		2. Duration in milliseconds, 0 to play until tone_stop().
+ * Returns: None.
+ */
+void tone_start(uint16_t frequency, uint16_t duration) {
+	uint8_t i;
+	uint32_t top = 0;
+
+	if (frequency == 0) {
+		tone_stop();
+		return;
+	}
+	if (frequency > TONE_MAXHZ) {
+		frequency = TONE_MAXHZ;
+	}
+
+	// Take the finest prescaler at which the compare value still fits 8 bits
+	for(i = 0; i < sizeof(tone_prescalers) / sizeof(tone_prescalers[0]); i++) {
+		top = F_CPU / (2UL * tone_prescalers[i] * frequency);
+		if (top <= 256) {
+			break;
+		}
+	}
+	if (top > 256) {  // Lower than the slowest prescaler allows
+		i--;
+		top = 256;
+	}
+	if (top == 0) {
+		top = 1;
+	}
+
+	TCCR0B = 0;  // Stop while reconfiguring
+	tone_toggles = (duration == 0) ? 0 :
+		F_CPU / (tone_prescalers[i] * top) * duration / 1000;
+	if (duration != 0 && tone_toggles == 0) {
+		tone_toggles = 1;
+	}
+	TCNT0 = 0;
+	OCR0A = top - 1;
+	OCR0B = 0;
+	TCCR0A = (1 << COM0B0) | (1 << WGM01);  // Toggle OC0B on compare match, CTC mode with OCR0A as top
+	TIFR0 = (1 << OCF0A);
+	TIMSK0 |= (1 << OCIE0A);
+	tone_active = 1;
+	TCCR0B = tone_clockselect[i];
+}
+
+/**
+ * Function: Stops the tone and leaves the pin low.
+ * Argument: None.
+ * Returns: None.
+ */
+void tone_stop(void) {
+	TCCR0B = 0;
+	TCCR0A = 0;  // Disconnect OC0B, the port drives the pin again
+	TIMSK0 &= ~(1 << OCIE0A);
+	TONE_PORT &= ~(1 << TONE_PIN);
+	tone_toggles = 0;
+	tone_active = 0;
+}
+
+/**
+ * Function: Checks if a tone is playing.
+ * Argument: None.
+ * Returns: 1 while a tone plays, otherwise 0.
+ */
+uint8_t tone_playing(void) {
+	return tone_active;
+}
@@ -0,0 +1,30 @@
+/**
+ * Title:   	Tone generator
+ *
+ * Produces a square wave on OC0B (PD5) with timer 0 in CTC mode, so the CPU is free while a tone plays.
+ * The compare match interrupt counts the half periods to stop the tone after its duration.
+ */
+
+#ifndef TONE_H_
+#define TONE_H_
+
+#include <stdint.h>
+#include <avr/io.h>
+
+#include "pins.h"
+
+//setup port, has to be the OC0B pin, see pins.h
+#define TONE_DDR PIN_DDRREG(BOARD_TONE)
+#define TONE_PORT PIN_PORTREG(BOARD_TONE)
+#define TONE_PIN PIN_BIT(BOARD_TONE)
+
+//highest frequency, keeps the toggle count of a 65 s tone within 32 bits
+#define TONE_MAXHZ 20000
+
+//functions
+extern void tone_init(void);
+extern void tone_start(uint16_t frequency, uint16_t duration);
+extern void tone_stop(void);
+extern uint8_t tone_playing(void);
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Title:   	Trend graph
+ *
+ * See trend.h.
+ */
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+#include "trend.h"
+#include "hd44780.h"
+
+#if LCD_GLYPHS != TREND_LEVELS
+#error "the trend graph needs LCD_GLYPHS set to TREND_LEVELS in hd44780_settings.h"
+#endif
+
+// Bars from one to eight dots high, glyph n is n + 1 dots
+const uint8_t lcd_glyphs[LCD_GLYPHS][LCD_GLYPH_ROWS] PROGMEM = {
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F},
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F},
+	{0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F},
+	{0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F}
+};
+
+/**
+ * Function: Puts the trend of a history channel in the LCD frame buffer, at its cursor.
+ * Bars without history yet are left blank.
+ * Arguments:
+ * 		1. History channel.
+ * 		2. Smallest spread the graph is scaled to, in the unit of the channel.
+ * Returns: None.
+ */
+void trend_put(uint8_t channel, int16_t range) {
+	int16_t values[TREND_CELLS];
+	uint8_t filled = history_series(channel, TREND_SPAN, TREND_CELLS, values);
+	uint8_t first = TREND_CELLS - filled;
+
+	for (uint8_t i = 0; i < first; i++) {
+		lcd_buffer_putc(' ');
+	}
+	if (filled == 0) {
+		return;
+	}
+
+	// Scale between the extremes of the bars
+	int16_t low = values[first];
+	int16_t high = values[first];
+
+	for (uint8_t i = first + 1; i < TREND_CELLS; i++) {
+		if (values[i] < low) {
+			low = values[i];
+		}
+		if (values[i] > high) {
+			high = values[i];
+		}
+	}
+	if (high - low < range) {
+		low -= (range - (high - low)) / 2;
+	}
+	else {
+		range = high - low;
+	}
+	if (range < 1) {
+		range = 1;
+	}
+
+	for (uint8_t i = first; i < TREND_CELLS; i++) {
+		int16_t level = ((int32_t)(values[i] - low) * (TREND_LEVELS - 1) + range / 2) / range;
+
+		if (level < 0) {
+			level = 0;
+		}
+		else if (level > TREND_LEVELS - 1) {
+			level = TREND_LEVELS - 1;
+		}
+		lcd_buffer_putc(LCD_GLYPH(level));
+	}
+}
@@ -0,0 +1,31 @@
+/**
+ * Title:   	Trend graph
+ *
+ * Draws a channel of the history as a bar graph of TREND_CELLS characters on the
+ * LCD, one bar per TREND_SPAN samples. The bars are the 8 custom characters of
+ * lcd_glyphs[], one to eight dots high, which lcd_init() uploads once. Drawing only
+ * fills the frame buffer, so lcd_buffer_flush() sends just the bars that changed:
+ * at most one per stored history sample once the page is on the screen.
+ *
+ * The graph is scaled between the lowest and highest bar, a spread smaller than the
+ * given range is centered so the noise of a steady reading stays flat.
+ */
+
+#ifndef TREND_H_
+#define TREND_H_
+
+#include <stdint.h>
+
+#include "history.h"
+
+//bars of the graph and the history samples every bar averages, together the day window
+#define TREND_CELLS 8
+#define TREND_SPAN (HISTORY_DAY_SAMPLES / TREND_CELLS)
+
+//bar heights, one custom character each
+#define TREND_LEVELS 8
+
+//functions
+extern void trend_put(uint8_t channel, int16_t range);
+
+#endif
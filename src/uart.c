@@ -0,0 +1,151 @@
+/**
+ * Title:   	Interrupt driven UART
+ *
+ * See uart.h for an explanation of the buffering.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#include "uart.h"
+
+#define UART_TXMASK (UART_TXSIZE - 1)
+#define UART_RXMASK (UART_RXSIZE - 1)
+
+#if (UART_TXSIZE & UART_TXMASK) != 0 || UART_TXSIZE > 256 || (UART_RXSIZE & UART_RXMASK) != 0 || UART_RXSIZE > 256
+#error "UART ring buffer sizes have to be a power of 2 up to 256"
+#endif
+
+static uint8_t uart_txbuffer[UART_TXSIZE];
+static volatile uint8_t uart_txhead = 0;	// next free position, only written by the main loop
+static volatile uint8_t uart_txtail = 0;	// next byte to send, only written by the interrupt
+
+static uint8_t uart_rxbuffer[UART_RXSIZE];
+static volatile uint8_t uart_rxhead = 0;	// only written by the interrupt
+static volatile uint8_t uart_rxtail = 0;	// only written by the main loop
+static volatile uint16_t uart_rxdropped = 0;
+
+/**
+ * Interupt triggered while the transmit data register is empty. Sends the next byte, or
+ * switches itself off when the ring is empty.
+ */
+ISR(USART_UDRE_vect) {
+	uint8_t tail = uart_txtail;
+
+	if (tail == uart_txhead) {
+		UCSR0B &= ~(1 << UDRIE0);
+		return;
+	}
+	UDR0 = uart_txbuffer[tail];
+	uart_txtail = (tail + 1) & UART_TXMASK;
+}
+
+/**
+ * Interupt triggered for every received byte. Bytes that do not fit are counted and dropped.
+ */
+ISR(USART_RX_vect) {
+	uint8_t data = UDR0;
+	uint8_t next = (uart_rxhead + 1) & UART_RXMASK;
+
+	if (next == uart_rxtail) {
+		uart_rxdropped++;
+		return;
+	}
+	uart_rxbuffer[uart_rxhead] = data;
+	uart_rxhead = next;
+}
+
+/**
+ * Function: Sets up USART0 for UART_BAUD, 8 data bits, no parity, 1 stop bit. Interrupts have to be enabled by the caller.
+ * Argument: None.
+ * Returns: None.
+ */
+void uart_init(void) {
+	UBRR0H = (uint8_t)(UART_UBRR >> 8);
+	UBRR0L = (uint8_t)UART_UBRR;
+	UCSR0A = (1 << U2X0);
+	UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
+	UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
+}
+
+/**
+ * Function: Returns how many bytes still fit in the transmit ring.
+ * Argument: None.
+ * Returns: free bytes.
+ */
+uint8_t uart_txfree(void) {
+	return UART_TXMASK - ((uart_txhead - uart_txtail) & UART_TXMASK);
+}
+
+/**
+ * Function: Queues a byte for sending.
+ * Argument: Byte.
+ * Returns: 0 when queued, -1 when the ring is full.
+ */
+int8_t uart_putc(uint8_t c) {
+	return uart_write(&c, 1);
+}
+
+/**
+ * Function: Queues a block of bytes for sending, either all of them or none.
+ * Arguments:
+ * 		1. Bytes.
+ * 		2. Amount of bytes.
+ * Returns: 0 when queued, -1 when they do not fit in the ring.
+ */
+int8_t uart_write(const uint8_t *data, uint8_t length) {
+	if (length > uart_txfree()) {
+		return -1;
+	}
+
+	uint8_t head = uart_txhead;
+	for (uint8_t i = 0; i < length; i++) {
+		uart_txbuffer[head] = data[i];
+		head = (head + 1) & UART_TXMASK;
+	}
+	uart_txhead = head;  // Publish the bytes only when they are all in the ring
+
+	UCSR0B |= (1 << UDRIE0);
+	return 0;
+}
+
+/**
+ * Function: Takes the oldest received byte.
+ * Argument: None.
+ * Returns: byte, or -1 when nothing was received.
+ */
+int16_t uart_getc(void) {
+	uint8_t tail = uart_rxtail;
+
+	if (tail == uart_rxhead) {
+		return -1;
+	}
+	uint8_t data = uart_rxbuffer[tail];
+	uart_rxtail = (tail + 1) & UART_RXMASK;
+	return data;
+}
+
+/**
+ * Function: Returns how many received bytes wait to be read.
+ * Argument: None.
+ * Returns: amount of bytes.
+ */
+uint8_t uart_available(void) {
+	return (uart_rxhead - uart_rxtail) & UART_RXMASK;
+}
+
+/**
+ * Function: Returns how many received bytes were lost because the receive ring was full.
+ * Argument: None.
+ * Returns: amount of bytes.
+ */
+uint16_t uart_dropped(void) {
+	uint16_t dropped;
+
+	uint8_t sreg = SREG;
+	cli();
+	dropped = uart_rxdropped;
+	SREG = sreg;
+
+	return dropped;
+}
@@ -0,0 +1,480 @@
+/**
+ * Title:   	On-target timing benchmark
+ *
+ * Runs the firmware image under simavr, cycle by cycle as an ATmega328P at 16 MHz.
+ * A simulated DHT11 answers every reading on PD6, the tone pin PD5, the LED matrix
+ * lines PB2/3/5 and the LCD bus are captured. The LCD bus is decoded into the screen
+ * contents, so the time until a new reading is readable on the LCD can be measured.
+ *
+ * The scenario: the room is at BENCH_ROOM, changes to BENCH_CHANGE at BENCH_CHANGE_MS
+ * and goes over the upper limit at BENCH_BREACH_MS. Reported are the latencies of
+ * the first reading that carries a change until the LCD shows it and until the first
+ * edge on the tone pin, and the jitter of the LED matrix frames. Any latency over its
+ * BENCH_SLA_ limit makes the run fail, so the benchmark can gate a change.
+ *
+ * Usage: bench firmware.elf
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_time.h"
+#include "sim_cycle_timers.h"
+#include "avr_ioport.h"
+#include "avr_spi.h"
+#include "avr_uart.h"
+
+#define BENCH_MCU "atmega328p"
+#define BENCH_FREQUENCY 16000000
+
+//scenario, DHT11 readings in whole units
+#define BENCH_ROOM_TEMPERATURE 21
+#define BENCH_ROOM_HUMIDITY 45
+#define BENCH_CHANGE_TEMPERATURE 24		// within the default limits
+#define BENCH_CHANGE_MS 30000			// after the alarm dwell time since boot
+#define BENCH_BREACH_TEMPERATURE 35		// over TEMP_LIMIT_MAX
+#define BENCH_BREACH_MS 60000
+#define BENCH_END_MS 100000
+
+//LED matrix frame period of the firmware, ANIMATION_FRAME_MS
+#define BENCH_FRAME_MS 120
+//transactions closer together than this belong to the same frame
+#define BENCH_FRAMEGAP_MS 5
+
+//limits the run is held to, what the current design promises: a changed reading is on
+//the LCD within three display steps, an alarm page and its tone come on as soon as the
+//filters and the alarm confirmation accept the breach, frames keep their period within a
+//few milliseconds
+#define BENCH_SLA_LCD_MS 13000
+#define BENCH_SLA_TONE_MS 10000
+#define BENCH_SLA_JITTER_US 5000
+
+//pins
+#define BENCH_DHT_PIN 6			// PD6
+#define BENCH_TONE_PIN 5		// PD5
+#define BENCH_LCD_RS_PIN 7		// PD7
+#define BENCH_LCD_E_PIN 0		// PB0
+#define BENCH_LCD_RW_PIN 4		// PC4, DB4-DB7 on PC0-PC3
+#define BENCH_LOAD_PIN 2		// PB2
+#define BENCH_CLK_PIN 5			// PB5, the data on PB3 comes from the SPI output
+
+//sensor waveform, response plus 40 bits
+#define BENCH_DHT_EDGES (3 + 2 * 40 + 1)
+
+typedef struct {
+	uint32_t us;		// time since the previous edge
+	uint8_t level;
+} bench_edge_t;
+
+static avr_t *avr;
+static avr_irq_t *bench_dhtirq;
+
+//sensor
+static bench_edge_t bench_dhtedges[BENCH_DHT_EDGES];
+static uint8_t bench_dhtedge = 0;
+static uint8_t bench_dhtdriving = 0;		// the edge is ours, not the firmware's
+static avr_cycle_count_t bench_dhtlow = 0;		// cycle the firmware pulled the line low, 0 when it didn't
+static uint8_t bench_temperature_sent = BENCH_ROOM_TEMPERATURE;
+static uint32_t bench_readings = 0;
+
+//latencies, cycle of the cause and of the effect, 0 until seen
+static avr_cycle_count_t bench_changesent = 0;
+static avr_cycle_count_t bench_changeshown = 0;
+static avr_cycle_count_t bench_breachsent = 0;
+static avr_cycle_count_t bench_breachheard = 0;
+
+//LCD bus and the screen decoded from it
+static uint8_t bench_lcdpins = 0;		// DB4-DB7 in bits 0-3, RW in bit 4
+static uint8_t bench_lcdrs = 0;
+static uint8_t bench_lcd4bit = 0;
+static uint8_t bench_lcdhigh = 0;		// first nibble of a byte received
+static uint8_t bench_lcdnibble = 0;
+static uint8_t bench_lcdaddress = 0;
+static uint8_t bench_lcdcgram = 0;		// data goes to CGRAM, the custom characters
+static char bench_ddram[0x80];
+static uint32_t bench_lcdbytes = 0;
+
+//LED matrix
+static uint32_t bench_spibytes = 0;
+static uint32_t bench_clockedges = 0;		// bit-banged clock, MAX7219_SPI 0
+static avr_cycle_count_t bench_lasttransaction = 0;
+static avr_cycle_count_t bench_framestart = 0;
+static uint32_t bench_frames = 0;
+static uint32_t bench_jittermax = 0;		// microseconds
+static uint64_t bench_jittertotal = 0;
+
+/**
+ * Function: Milliseconds between two cycles.
+ * Arguments:
+ * 		1. Earlier cycle.
+ * 		2. Later cycle.
+ * Returns: Milliseconds.
+ */
+static double bench_ms(avr_cycle_count_t from, avr_cycle_count_t to) {
+	return avr_cycles_to_usec(avr, to - from) / 1000.0;
+}
+
+/**
+ * Function: Applies the next edge of the sensor waveform.
+ * Arguments: As avr_cycle_timer_t.
+ * Returns: Cycle of the next edge, 0 after the last one.
+ */
+static avr_cycle_count_t bench_dhtstep(avr_t *avr, avr_cycle_count_t when, void *param) {
+	bench_dhtdriving = 1;
+	avr_raise_irq(bench_dhtirq, bench_dhtedges[bench_dhtedge].level);
+	bench_dhtdriving = 0;
+
+	if (++bench_dhtedge < BENCH_DHT_EDGES) {
+		return when + avr_usec_to_cycles(avr, bench_dhtedges[bench_dhtedge].us);
+	}
+
+	// Last edge, the reading is complete
+	if (bench_temperature_sent == BENCH_CHANGE_TEMPERATURE && bench_changesent == 0) {
+		bench_changesent = when;
+	}
+	if (bench_temperature_sent == BENCH_BREACH_TEMPERATURE && bench_breachsent == 0) {
+		bench_breachsent = when;
+	}
+	bench_readings++;
+	return 0;
+}
+
+/**
+ * Function: Starts answering a reading with the reading of the room at this time.
+ * Argument: None.
+ * Returns: None.
+ */
+static void bench_dhtanswer(void) {
+	uint32_t ms = avr_cycles_to_usec(avr, avr->cycle) / 1000;
+	uint8_t temperature = BENCH_ROOM_TEMPERATURE;
+	uint8_t humidity = BENCH_ROOM_HUMIDITY;
+	uint8_t n = 0;
+
+	if (ms >= BENCH_BREACH_MS) {
+		temperature = BENCH_BREACH_TEMPERATURE;
+	}
+	else if (ms >= BENCH_CHANGE_MS) {
+		temperature = BENCH_CHANGE_TEMPERATURE;
+	}
+
+	uint8_t bytes[5] = {humidity, 0, temperature, 0, (uint8_t)(humidity + temperature)};
+
+	bench_dhtedges[n++] = (bench_edge_t){30, 0};  // Response low
+	bench_dhtedges[n++] = (bench_edge_t){80, 1};
+	bench_dhtedges[n++] = (bench_edge_t){80, 0};
+	for (uint8_t i = 0; i < 40; i++) {
+		bench_dhtedges[n++] = (bench_edge_t){50, 1};
+		bench_dhtedges[n++] = (bench_edge_t){(bytes[i / 8] & (1 << (7 - (i % 8)))) ? 70 : 26, 0};
+	}
+	bench_dhtedges[n++] = (bench_edge_t){50, 1};  // Line released, the pull-up takes it high
+
+	bench_temperature_sent = temperature;
+	bench_dhtedge = 0;
+	avr_cycle_timer_register_usec(avr, bench_dhtedges[0].us, bench_dhtstep, NULL);
+}
+
+/**
+ * Function: Watches the sensor line for the start pulse of the firmware.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_dhtpin(avr_irq_t *irq, uint32_t value, void *param) {
+	static uint32_t previous = 0;
+
+	if (value == previous) {  // Every write to the port notifies all of its pins
+		return;
+	}
+	previous = value;
+
+	if (bench_dhtdriving) {
+		return;
+	}
+	if (!value) {
+		bench_dhtlow = avr->cycle;
+	}
+	else if (bench_dhtlow != 0) {  // Released after a start pulse
+		if (bench_ms(bench_dhtlow, avr->cycle) >= 18) {  // Shortest start pulse a DHT11 answers to
+			bench_dhtanswer();
+		}
+		bench_dhtlow = 0;
+	}
+}
+
+/**
+ * Function: Records the first edge on the tone pin after the breach.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_tonepin(avr_irq_t *irq, uint32_t value, void *param) {
+	static uint32_t previous = 0;
+
+	if (value == previous) {
+		return;
+	}
+	previous = value;
+
+	if (bench_breachsent != 0 && bench_breachheard == 0) {
+		bench_breachheard = avr->cycle;
+	}
+}
+
+/**
+ * Function: Checks if the upper line of the screen shows the changed temperature.
+ * Argument: None.
+ * Returns: 1 when it does.
+ */
+static uint8_t bench_lcdshows(void) {
+	char expected[8];
+	char line[17];
+
+	snprintf(expected, sizeof(expected), "%dC", BENCH_CHANGE_TEMPERATURE);
+	memcpy(line, bench_ddram, 16);
+	line[16] = 0;
+	return strstr(line, expected) != NULL;
+}
+
+/**
+ * Function: Handles a byte written to the LCD controller.
+ * Arguments:
+ * 		1. Byte.
+ * 		2. 1 for data, 0 for an instruction.
+ * Returns: None.
+ */
+static void bench_lcdbyte(uint8_t data, uint8_t rs) {
+	bench_lcdbytes++;
+	if (rs && bench_lcdcgram) {  // Glyph rows are not part of the screen
+		return;
+	}
+	if (rs) {
+		bench_ddram[bench_lcdaddress & 0x7F] = data;
+		bench_lcdaddress = (bench_lcdaddress + 1) & 0x7F;
+		if (bench_changesent != 0 && bench_changeshown == 0 && bench_lcdshows()) {
+			bench_changeshown = avr->cycle;
+		}
+	}
+	else if (data & 0x80) {  // Set DDRAM address
+		bench_lcdaddress = data & 0x7F;
+		bench_lcdcgram = 0;
+	}
+	else if (data & 0x40) {  // Set CGRAM address
+		bench_lcdcgram = 1;
+	}
+	else if (data == 0x01) {  // Clear
+		memset(bench_ddram, ' ', sizeof(bench_ddram));
+		bench_lcdaddress = 0;
+		bench_lcdcgram = 0;
+	}
+	else if ((data & 0xFE) == 0x02) {  // Home
+		bench_lcdaddress = 0;
+		bench_lcdcgram = 0;
+	}
+	else if ((data & 0xE0) == 0x20) {  // Function set, the interface width takes effect right away
+		bench_lcd4bit = !(data & 0x10);
+	}
+}
+
+/**
+ * Function: Tracks DB4-DB7 and RW.
+ * Arguments: As avr_irq_notify_t, the pin is passed as parameter.
+ * Returns: None.
+ */
+static void bench_lcdportc(avr_irq_t *irq, uint32_t value, void *param) {
+	uint8_t bit = 1 << (uintptr_t)param;
+
+	bench_lcdpins = value ? (bench_lcdpins | bit) : (bench_lcdpins & ~bit);
+}
+
+/**
+ * Function: Tracks RS.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_lcdrspin(avr_irq_t *irq, uint32_t value, void *param) {
+	bench_lcdrs = value;
+}
+
+/**
+ * Function: Latches a nibble on the falling edge of E, reads with RW high are skipped.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_lcdepin(avr_irq_t *irq, uint32_t value, void *param) {
+	static uint32_t previous = 0;
+
+	if (value == previous) {
+		return;
+	}
+	previous = value;
+
+	if (value || (bench_lcdpins & (1 << BENCH_LCD_RW_PIN))) {
+		return;
+	}
+	uint8_t nibble = bench_lcdpins & 0x0F;
+
+	if (!bench_lcd4bit) {  // 8-bit interface, only the upper nibble is wired
+		bench_lcdbyte(nibble << 4, bench_lcdrs);
+		bench_lcdhigh = 0;
+	}
+	else if (!bench_lcdhigh) {
+		bench_lcdnibble = nibble << 4;
+		bench_lcdhigh = 1;
+	}
+	else {
+		bench_lcdhigh = 0;
+		bench_lcdbyte(bench_lcdnibble | nibble, bench_lcdrs);
+	}
+}
+
+/**
+ * Function: Ends a transaction to the LED matrix, groups the transactions into frames.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_loadpin(avr_irq_t *irq, uint32_t value, void *param) {
+	static uint32_t previous = 0;
+
+	if (value == previous) {
+		return;
+	}
+	previous = value;
+
+	if (!value) {
+		return;
+	}
+	if (bench_lasttransaction == 0 || bench_ms(bench_lasttransaction, avr->cycle) > BENCH_FRAMEGAP_MS) {
+		if (bench_framestart != 0) {  // Deviation from a whole number of frame periods
+			uint32_t us = avr_cycles_to_usec(avr, avr->cycle - bench_framestart);
+			uint32_t periods = (us + BENCH_FRAME_MS * 500) / (BENCH_FRAME_MS * 1000);
+			uint32_t jitter = abs((int32_t)(us - periods * BENCH_FRAME_MS * 1000));
+
+			if (periods > 0) {
+				bench_frames++;
+				bench_jittertotal += jitter;
+				if (jitter > bench_jittermax) {
+					bench_jittermax = jitter;
+				}
+			}
+		}
+		bench_framestart = avr->cycle;
+	}
+	bench_lasttransaction = avr->cycle;
+}
+
+/**
+ * Function: Counts the bytes shifted out by the SPI hardware.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_spibyte(avr_irq_t *irq, uint32_t value, void *param) {
+	bench_spibytes++;
+}
+
+/**
+ * Function: Counts the rising edges of a bit-banged clock.
+ * Arguments: As avr_irq_notify_t.
+ * Returns: None.
+ */
+static void bench_clockpin(avr_irq_t *irq, uint32_t value, void *param) {
+	static uint32_t previous = 0;
+
+	if (value == previous) {
+		return;
+	}
+	previous = value;
+
+	if (value) {
+		bench_clockedges++;
+	}
+}
+
+/**
+ * Function: Prints a latency and checks it against its limit.
+ * Arguments:
+ * 		1. Name.
+ * 		2. Cycle of the cause.
+ * 		3. Cycle of the effect, 0 when it never happened.
+ * 		4. Limit in milliseconds.
+ * Returns: 0 within the limit, 1 otherwise.
+ */
+static int bench_report(const char *name, avr_cycle_count_t cause, avr_cycle_count_t effect, uint32_t limit) {
+	if (cause == 0 || effect == 0) {
+		printf("%-24s never seen, limit %u ms  FAIL\n", name, limit);
+		return 1;
+	}
+	double ms = bench_ms(cause, effect);
+	printf("%-24s %9.1f ms, limit %u ms  %s\n", name, ms, limit, ms <= limit ? "ok" : "FAIL");
+	return ms > limit;
+}
+
+int main(int argc, char *argv[]) {
+	elf_firmware_t firmware;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s firmware.elf\n", argv[0]);
+		return 2;
+	}
+	memset(&firmware, 0, sizeof(firmware));
+	if (elf_read_firmware(argv[1], &firmware) != 0) {
+		fprintf(stderr, "%s: can't read %s\n", argv[0], argv[1]);
+		return 2;
+	}
+	avr = avr_make_mcu_by_name(firmware.mmcu[0] ? firmware.mmcu : BENCH_MCU);
+	if (!avr) {
+		fprintf(stderr, "%s: unknown mcu\n", argv[0]);
+		return 2;
+	}
+	avr_init(avr);
+	avr_load_firmware(avr, &firmware);
+	if (!avr->frequency) {
+		avr->frequency = BENCH_FREQUENCY;
+	}
+	memset(bench_ddram, ' ', sizeof(bench_ddram));
+
+	// Keep the telemetry off the console
+	uint32_t flags = 0;
+	avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS('0'), &flags);
+	flags &= ~AVR_UART_FLAG_STDIO;
+	avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS('0'), &flags);
+
+	bench_dhtirq = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), BENCH_DHT_PIN);
+	avr_irq_register_notify(bench_dhtirq, bench_dhtpin, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), BENCH_TONE_PIN), bench_tonepin, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('D'), BENCH_LCD_RS_PIN), bench_lcdrspin, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), BENCH_LCD_E_PIN), bench_lcdepin, NULL);
+	for (uintptr_t pin = 0; pin <= BENCH_LCD_RW_PIN; pin++) {
+		avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('C'), pin), bench_lcdportc, (void *)pin);
+	}
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), BENCH_LOAD_PIN), bench_loadpin, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), BENCH_CLK_PIN), bench_clockpin, NULL);
+	avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), bench_spibyte, NULL);
+
+	avr_cycle_count_t end = avr_usec_to_cycles(avr, (uint64_t)BENCH_END_MS * 1000);
+	int state = cpu_Running;
+	while (avr->cycle < end && state != cpu_Done && state != cpu_Crashed) {
+		state = avr_run(avr);
+	}
+	if (state == cpu_Crashed) {
+		printf("firmware crashed at %.1f ms\n", bench_ms(0, avr->cycle));
+		return 1;
+	}
+
+	int failed = 0;
+	printf("%u sensor readings answered, %u LCD bytes, %u LED matrix bytes\n",
+		bench_readings, bench_lcdbytes, bench_spibytes + bench_clockedges / 8);
+	failed |= bench_report("reading -> LCD", bench_changesent, bench_changeshown, BENCH_SLA_LCD_MS);
+	failed |= bench_report("limit breach -> tone", bench_breachsent, bench_breachheard, BENCH_SLA_TONE_MS);
+	if (bench_frames == 0) {
+		printf("%-24s no frames seen  FAIL\n", "animation frame jitter");
+		failed = 1;
+	}
+	else {
+		printf("%-24s %9.1f us average, %u us at most over %u frames, limit %u us  %s\n", "animation frame jitter",
+			(double)bench_jittertotal / bench_frames, bench_jittermax, bench_frames, BENCH_SLA_JITTER_US,
+			bench_jittermax <= BENCH_SLA_JITTER_US ? "ok" : "FAIL");
+		failed |= bench_jittermax > BENCH_SLA_JITTER_US;
+	}
+	return failed;
+}
@@ -0,0 +1,362 @@
+/**
+ * Title:   	Host benchmarks
+ *
+ * Runs the firmware against the mocked registers of lib/avrmock and reports what the
+ * optimisations are about: bytes shifted to the LED matrix per frame, LCD writes per
+ * refresh and per trend graph update, busy-wait time per millisecond of the main loop,
+ * filter throughput over the traces in traces.h and the time an alarm takes to show.
+ * Run with "pio test -e native -v" to see the reports.
+ *
+ * There is no CPU here, the main loop is simulated: every millisecond the tick
+ * interrupt runs, then the ready tasks, then as many LCD queue interrupts as fit
+ * in a millisecond. The sensor answers a started reading with a DHT11 waveform
+ * as timer 1 captures it. Cycle counts on the target come from PROFILE instead.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unity.h>
+
+#include "mock.h"
+#include "avr/io.h"
+#include "avr/interrupt.h"
+
+#include "sched.h"
+#include "dht.h"
+#include "sensor.h"
+#include "filter.h"
+#include "hd44780.h"
+#include "animation.h"
+#include "history.h"
+#include "trend.h"
+#include "melody.h"
+#include "display.h"
+#include "config.h"
+#include "traces.h"
+
+//timer 2 compare matches per millisecond, one every 40 us
+#define BENCH_LCDTICKS 25
+
+//simulated run time of the main loop benchmark
+#define BENCH_RUN_MS 60000
+
+//times every trace is run through the filters, for a stable throughput figure
+#define BENCH_FILTER_RUNS 2000
+
+//interrupts and firmware, see main.c
+extern void TIMER1_COMPA_vect(void);
+extern void TIMER2_COMPA_vect(void);
+extern void USART_UDRE_vect(void);
+extern void DHT_PCINT_vect(void);
+extern void setup(void);
+extern void checkStats(void);
+extern int isNewResultValid(sensor_t *sensor);
+extern void printTempHum_Current(uint8_t sensor, int temperature, int humidity);
+extern void printTemp_History(uint8_t sensor, int temperature_max, int temperature_min);
+extern void task_animation(void);
+extern const animation_step_t ANIMATION_CHECK[];
+
+static const trace_t *bench_trace = &traces[0];	// readings the simulated sensor answers with
+static uint16_t bench_reading = 0;
+static uint32_t bench_readings = 0;				// waveforms sent
+
+/**
+ * Function: Drives the sensor line and timestamps an edge as timer 1 would.
+ * Arguments:
+ * 		1. Microseconds since the line was released.
+ * 		2. Level of the line.
+ * Returns: None.
+ */
+static void bench_edge(uint32_t us, uint8_t high) {
+	TCNT1 = (us * SCHED_COUNTSPERUS) % SCHED_COUNTSPERMS;
+	if (high) {
+		PIND |= (1 << sensors[0].pin);
+	}
+	else {
+		PIND &= ~(1 << sensors[0].pin);
+	}
+	DHT_PCINT_vect();
+}
+
+/**
+ * Function: Answers a released sensor line with a DHT11 reading: the 80 us response,
+ * then 40 bits of a 50 us low and a 26 us (0) or 70 us (1) high pulse.
+ * Arguments:
+ * 		1. Temperature.
+ * 		2. Humidity.
+ * Returns: None.
+ */
+static void bench_sensor(uint8_t temperature, uint8_t humidity) {
+	uint8_t bytes[5] = {humidity, 0, temperature, 0, (uint8_t)(humidity + temperature)};
+	uint32_t us = 30;
+
+	bench_edge(us, 0);  // Sensor pulls the line low as a response
+	us += 80;
+	bench_edge(us, 1);
+	us += 80;
+	bench_edge(us, 0);
+	for (uint8_t i = 0; i < 40; i++) {
+		us += 50;
+		bench_edge(us, 1);
+		us += (bytes[i / 8] & (1 << (7 - (i % 8)))) ? 70 : 26;
+		bench_edge(us, 0);
+	}
+	PIND |= (1 << sensors[0].pin);  // Pull-up takes the line high again
+	TCNT1 = 0;
+}
+
+/**
+ * Function: Sends the queued LCD bytes, without the limit of a millisecond.
+ * Argument: None.
+ * Returns: None.
+ */
+static void bench_lcddrain(void) {
+	for (uint16_t i = 0; i < 10000 && (TIMSK2 & (1 << OCIE2A)); i++) {
+		TIMER2_COMPA_vect();
+	}
+}
+
+/**
+ * Function: Sends the characters of the frame buffer that changed.
+ * Argument: None.
+ * Returns: pulses of the LCD enable line it took.
+ */
+static uint32_t bench_lcdflush(void) {
+	mock_reset();
+	lcd_buffer_flush();
+	bench_lcddrain();
+	mock_sync();
+	return mock_toggles(MOCK_PORTB, LCD_E_PIN) / 2;
+}
+
+/**
+ * Function: Simulates a millisecond of the main loop.
+ * Argument: None.
+ * Returns: None.
+ */
+static void bench_millisecond(void) {
+	TIMER1_COMPA_vect();
+	sched_run();
+
+	for (uint8_t i = 0; i < BENCH_LCDTICKS && (TIMSK2 & (1 << OCIE2A)); i++) {
+		TIMER2_COMPA_vect();
+	}
+	while (UCSR0B & (1 << UDRIE0)) {
+		USART_UDRE_vect();
+	}
+
+	// A reading is running once the line is released with its pin change interrupt on, the first sensor answers
+	if (!(DDRD & (1 << sensors[0].pin)) && (PCMSK2 & (1 << sensors[0].pin))) {
+		const int8_t *reading = bench_trace->readings[bench_reading];
+		bench_sensor(reading[0], reading[1]);
+		bench_reading = (bench_reading + 1) % bench_trace->count;
+		bench_readings++;
+	}
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+/**
+ * Bytes shifted to the LED matrix per animation frame, against a full frame.
+ */
+static void test_animation_bytes(void) {
+	uint32_t frames = 0;
+	uint32_t bytes = 0;
+	uint32_t worst = 0;
+
+	animation_play(ANIMATION_CHECK, 1);
+	while (!animation_done()) {
+		mock_reset();
+		task_animation();
+		frames++;
+		bytes += mock_spibytes();
+		if (mock_spibytes() > worst) {
+			worst = mock_spibytes();
+		}
+	}
+
+	printf("LED matrix: %u frames, %.1f bytes per frame on average, %u at most, a full frame is %u\n",
+		frames, (double)bytes / frames, worst, 2 * 8);
+	TEST_ASSERT_TRUE(frames > 0);
+	TEST_ASSERT_TRUE(worst <= 2 * 8);
+}
+
+/**
+ * Pulses of the LCD enable line per screen refresh.
+ */
+static void test_lcd_writes(void) {
+	uint32_t pulses[3];
+	const int values[3][2] = {{21, 45}, {21, 45}, {22, 45}};
+
+	for (uint8_t i = 0; i < 3; i++) {
+		printTempHum_Current(0, values[i][0], values[i][1]);
+		pulses[i] = bench_lcdflush();
+	}
+
+	printf("LCD: %u enable pulses for a new screen, %u for the same screen, %u for a changed value\n",
+		pulses[0], pulses[1], pulses[2]);
+	TEST_ASSERT_TRUE(pulses[1] < pulses[0]);
+	TEST_ASSERT_TRUE(pulses[2] < pulses[0]);
+}
+
+/**
+ * Pulses of the LCD enable line for the history page with its trend graph, against a full screen.
+ */
+static void test_trend_writes(void) {
+	uint32_t pulses[4];
+	int16_t sample[HISTORY_CHANNELS] = {0};
+
+	history_init();
+	for (uint8_t i = 0; i < HISTORY_SIZE; i++) {
+		sample[HISTORY_TEMPERATURE] = 18 + i / 24;  // A degree every 4 hours
+		history_load(sample);
+	}
+
+	printTempHum_Current(0, 23, 45);  // Page before it on the display
+	bench_lcdflush();
+
+	printTemp_History(0, 23, 18);
+	pulses[0] = bench_lcdflush();
+	printTemp_History(0, 23, 18);
+	pulses[1] = bench_lcdflush();
+	sample[HISTORY_TEMPERATURE] = 25;
+	for (uint8_t i = 0; i < TREND_SPAN; i++) {  // Warmer for the span of a bar, the bars move a place
+		history_load(sample);
+	}
+	printTemp_History(0, 25, 18);
+	pulses[2] = bench_lcdflush();
+	lcd_buffer_invalidate();  // Whole screen, as it was written before the frame buffer
+	pulses[3] = bench_lcdflush();
+
+	printf("Trend: %u enable pulses for the history page, %u for the same page, %u a bar later, %u for the whole screen\n",
+		pulses[0], pulses[1], pulses[2], pulses[3]);
+	TEST_ASSERT_TRUE(pulses[0] <= pulses[3]);
+	TEST_ASSERT_EQUAL_UINT32(0, pulses[1]);
+	TEST_ASSERT_TRUE(pulses[2] < pulses[3]);
+	history_init();
+}
+
+/**
+ * Busy-wait time per millisecond of the main loop, against the blocking sensor reading it replaced.
+ */
+static void test_loop_delay(void) {
+	dht_value_t t = 0;
+	dht_value_t h = 0;
+
+	bench_trace = &traces[0];
+	bench_reading = 0;
+	bench_readings = 0;
+	mock_reset();
+	for (uint32_t ms = 0; ms < BENCH_RUN_MS; ms++) {
+		bench_millisecond();
+	}
+	double loop = mock_delayus() / BENCH_RUN_MS;
+	uint32_t readings = bench_readings;
+
+	// The blocking reader gives up at the first check when the line stays low, so this is its least delay
+	PIND &= ~(1 << sensors[0].pin);
+	mock_reset();
+	dht_getdata(sensors[0].pin, sensors[0].type, &t, &h);
+	double blocking = mock_delayus();
+	PIND |= (1 << sensors[0].pin);
+
+	printf("Main loop: %u readings in %u ms, %.2f us busy waiting per ms, the last accepted one %u ms old\n",
+		readings, BENCH_RUN_MS, loop, sensor_getage(0));
+	printf("Blocking dht_getdata(): at least %.0f us busy waiting per reading\n", blocking);
+	TEST_ASSERT_TRUE(readings > 0);
+	TEST_ASSERT_TRUE(loop < blocking);
+	TEST_ASSERT_TRUE(sensor_getage(0) <= config.sample_ms);  // Readings were accepted all the way
+}
+
+/**
+ * Readings per second through the filters, with the number of them that were rejected.
+ */
+static void test_filter_throughput(void) {
+	sensor_t *sensor = &sensors[0];
+	const filter_t temperature_fresh = sensor->temperature_filter;
+	const filter_t humidity_fresh = sensor->humidity_filter;
+
+	for (uint8_t i = 0; i < TRACES; i++) {
+		uint32_t accepted = 0;
+
+		sensor->temperature_filter = temperature_fresh;
+		sensor->humidity_filter = humidity_fresh;
+		for (uint16_t j = 0; j < traces[i].count; j++) {
+			sensor->temperature = traces[i].readings[j][0];
+			sensor->humidity = traces[i].readings[j][1];
+			accepted += isNewResultValid(sensor);
+		}
+		printf("Filter, %s: %u of %u readings accepted, %u rejected, %u resyncs\n", traces[i].name,
+			accepted, traces[i].count, sensor->temperature_filter.rejected + sensor->humidity_filter.rejected,
+			sensor->temperature_filter.resyncs + sensor->humidity_filter.resyncs);
+		if (i == 0) {
+			TEST_ASSERT_EQUAL_UINT32(traces[i].count, accepted);
+		}
+
+		// checkStats() as a whole, the filters with the alarms, telemetry and history
+		clock_t start = clock();
+		for (uint16_t run = 0; run < BENCH_FILTER_RUNS; run++) {
+			for (uint16_t j = 0; j < traces[i].count; j++) {
+				sensor->temperature = traces[i].readings[j][0];
+				sensor->humidity = traces[i].readings[j][1];
+				sensor->fresh = 1;
+				checkStats();
+			}
+			while (UCSR0B & (1 << UDRIE0)) {
+				USART_UDRE_vect();
+			}
+		}
+		double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+		double readings = (double)BENCH_FILTER_RUNS * traces[i].count;
+		printf("checkStats(), %s: %.0f ns per reading on the host\n", traces[i].name, seconds * 1e9 / readings);
+	}
+}
+
+/**
+ * Time from the start of an alarm to its page and warning pattern, against the display step time.
+ */
+static void test_alarm_latency(void) {
+	static const int8_t hot[][2] = {{35, 45}};
+	static const trace_t trace_hot = {"hot", hot, 1};
+	uint32_t alarm = 0;
+	uint32_t shown = 0;
+
+	bench_trace = &trace_hot;
+	bench_reading = 0;
+	for (uint32_t ms = 1; ms <= BENCH_RUN_MS && shown == 0; ms++) {
+		bench_millisecond();
+		if (alarm == 0 && sensors[0].temperature_dir == ALARM_HIGH) {
+			alarm = ms;
+		}
+		if (alarm != 0 && melody_playing() != MELODY_NONE) {
+			shown = ms;
+		}
+	}
+	bench_trace = &traces[0];
+
+	printf("Alarm: confirmed %u ms after the first hot reading, on the display %u ms later, a display step takes %u ms\n",
+		alarm, shown - alarm, config.display_ms);
+	TEST_ASSERT_TRUE(alarm != 0 && shown != 0);
+	TEST_ASSERT_TRUE(shown - alarm <= DISPLAY_POLL_MS);
+}
+
+int main(void) {
+	memset(mock_eeprom, 0xFF, sizeof(mock_eeprom));  // Erased EEPROM, the defaults are used
+	setup();
+	sei();
+	bench_lcddrain();
+
+	UNITY_BEGIN();
+	RUN_TEST(test_animation_bytes);
+	RUN_TEST(test_lcd_writes);
+	RUN_TEST(test_trend_writes);
+	RUN_TEST(test_loop_delay);
+	RUN_TEST(test_filter_throughput);
+	RUN_TEST(test_alarm_latency);  // Last, it leaves the filters and alarms at the hot reading
+	return UNITY_END();
+}
@@ -0,0 +1,53 @@
+/**
+ * Title:   	Sensor traces for the benchmarks
+ *
+ * DHT11 readings, one per sample interval, as {temperature, humidity} in whole units.
+ * They are shaped after what the sensor shows in a living room, not recorded from one:
+ * a quiet stretch, a door opening to the outside and a stretch with the single-reading
+ * glitches of a loose sensor wire. Replace them by logged telemetry to benchmark real data.
+ */
+
+#ifndef TRACES_H_
+#define TRACES_H_
+
+#include <stdint.h>
+
+typedef struct {
+	const char *name;
+	const int8_t (*readings)[2];
+	uint16_t count;
+} trace_t;
+
+// Slow drift of a degree, humidity wandering by one
+static const int8_t trace_quiet[][2] = {
+	{21, 45}, {21, 45}, {21, 46}, {21, 46}, {21, 45}, {21, 45}, {22, 45}, {21, 45},
+	{22, 45}, {22, 45}, {22, 44}, {22, 44}, {22, 45}, {22, 45}, {22, 45}, {22, 44},
+	{22, 44}, {22, 44}, {22, 45}, {22, 45}, {23, 45}, {22, 45}, {23, 44}, {23, 44},
+	{23, 44}, {23, 44}, {23, 45}, {23, 44}, {23, 44}, {23, 44}, {23, 43}, {23, 43}
+};
+
+// Door to the outside opened: a real drop faster than MAX_DELTA, then recovery
+static const int8_t trace_door[][2] = {
+	{22, 45}, {22, 45}, {22, 45}, {21, 47}, {14, 58}, {13, 60}, {12, 61}, {12, 62},
+	{12, 62}, {12, 61}, {13, 61}, {13, 60}, {14, 58}, {15, 57}, {15, 55}, {16, 54},
+	{17, 52}, {18, 51}, {18, 50}, {19, 49}, {19, 48}, {20, 47}, {20, 47}, {21, 46},
+	{21, 46}, {21, 46}, {22, 45}, {22, 45}, {22, 45}, {22, 45}, {22, 45}, {22, 45}
+};
+
+// Loose wire: single readings far off, in either value or both
+static const int8_t trace_glitch[][2] = {
+	{22, 45}, {22, 45}, {0, 45}, {22, 45}, {22, 46}, {22, 95}, {22, 46}, {22, 46},
+	{22, 45}, {50, 0}, {22, 45}, {22, 45}, {23, 45}, {23, 45}, {0, 0}, {23, 45},
+	{23, 44}, {23, 44}, {23, 44}, {61, 44}, {23, 44}, {23, 44}, {23, 1}, {23, 44},
+	{23, 44}, {23, 45}, {23, 45}, {0, 45}, {0, 45}, {23, 45}, {23, 45}, {23, 45}
+};
+
+static const trace_t traces[] = {
+	{"quiet room", trace_quiet, sizeof(trace_quiet) / sizeof(trace_quiet[0])},
+	{"door opening", trace_door, sizeof(trace_door) / sizeof(trace_door[0])},
+	{"loose wire", trace_glitch, sizeof(trace_glitch) / sizeof(trace_glitch[0])}
+};
+
+#define TRACES (sizeof(traces) / sizeof(traces[0]))
+
+#endif
@@ -0,0 +1,178 @@
+/**
+ * Title:   	LCD busy flag tests
+ *
+ * Runs the HD44780 driver in WAIT_MODE 2 against the busy flag the mock of lib/avrmock
+ * puts on DB7: the driver has to poll the flag while it is busy, fall back to fixed
+ * delays once it stays busy past the timeout, and try the flag again at lcd_init().
+ * Run with "pio test -e native -v".
+ *
+ * A read of the busy flag takes two E pulses with RW high in 4 bit mode, the mock
+ * counts them with mock_lcdreads().
+ */
+
+#include <unity.h>
+
+#include "mock.h"
+#include "avr/io.h"
+
+#include "hd44780.h"
+
+#if WAIT_MODE != 2 || RW_LINE_IMPLEMENTED != 1 || LCD_BITS != 4 || LCD_ASYNC != 1
+#error The tests are written for WAIT_MODE 2 with the RW line, in 4 bit mode with the write queue.
+#endif
+
+//mocked port of a pin of pins.h
+#define TEST_MOCKPORT(pin) TEST_MOCKPORT_(pin)
+#define TEST_MOCKPORT_(port, bit) MOCK_PORT##port
+
+//queue interrupts the display may be busy for before the driver stops polling, LCD_ASYNC_BUSYMAX of hd44780.c
+#define TEST_BUSYTICKS (2000 / LCD_ASYNC_TICK_US)
+
+//E pulses a busy read takes
+#define TEST_READPULSES 2
+
+//interrupt of the write queue
+extern void TIMER2_COMPA_vect(void);
+
+/**
+ * Function: Runs the queue interrupt until the queue is empty.
+ * Argument: None.
+ * Returns: Interrupts it took.
+ */
+static uint16_t test_drain(void) {
+	uint16_t ticks = 0;
+
+	while (ticks < 10000 && (TIMSK2 & (1 << OCIE2A))) {
+		TIMER2_COMPA_vect();
+		ticks++;
+	}
+	return ticks;
+}
+
+/**
+ * Function: Pulses of the E line since mock_reset(), a byte takes two in 4 bit mode.
+ * Argument: None.
+ * Returns: Pulses.
+ */
+static uint32_t test_pulses(void) {
+	mock_sync();
+	return mock_toggles(TEST_MOCKPORT(BOARD_LCD_E), LCD_E_PIN) / 2;
+}
+
+void setUp(void) {
+	mock_lcdbusy(0);
+	lcd_init();
+	test_drain();
+	mock_reset();
+}
+
+void tearDown(void) {
+}
+
+/**
+ * A display that is busy for a while after every byte is polled until it is ready, no delays are used.
+ */
+static void test_busy_poll(void) {
+	mock_lcdbusy(2 * TEST_READPULSES);  // Two busy reads after every byte
+	lcd_init();
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+	TEST_ASSERT_TRUE(mock_lcdreads() > 0);
+
+	mock_reset();
+	lcd_putc('A');
+	test_drain();
+	TEST_ASSERT_EQUAL_UINT32(3 * TEST_READPULSES, mock_lcdreads());  // Busy twice, then ready
+	TEST_ASSERT_EQUAL_UINT32(2 + 3 * TEST_READPULSES, test_pulses());
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+}
+
+/**
+ * After a data byte the address counter moves shortly after the flag clears, the next access waits 5 us.
+ */
+static void test_busy_settle(void) {
+	lcd_getc();  // Comes after an instruction, no wait
+	double instruction = mock_delayus();
+	mock_reset();
+	lcd_getc();  // Comes after reading data
+	double data = mock_delayus();
+
+	TEST_ASSERT_TRUE(data - instruction > 4.9 && data - instruction < 5.1);
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+}
+
+/**
+ * A flag that never clears while lcd_init() writes makes the driver fall back to delays, and it stops polling.
+ */
+static void test_busy_timeout(void) {
+	mock_lcdbusy(MOCK_LCDSTUCK);
+	lcd_init();
+	TEST_ASSERT_EQUAL_UINT8(1, lcd_busy_fallback());
+	TEST_ASSERT_TRUE(mock_lcdreads() > 0);
+
+	mock_reset();
+	lcd_putc('A');
+	test_drain();
+	TEST_ASSERT_EQUAL_UINT32(0, mock_lcdreads());
+	TEST_ASSERT_EQUAL_UINT32(2, test_pulses());  // The byte is sent anyway
+}
+
+/**
+ * A flag that gets stuck once the queue sends falls back after TEST_BUSYTICKS interrupts, the byte is sent then.
+ */
+static void test_busy_timeout_queue(void) {
+	mock_lcdbusy(MOCK_LCDSTUCK);
+	lcd_putc('A');
+	for (uint8_t i = 0; i < TEST_BUSYTICKS - 1; i++) {
+		TIMER2_COMPA_vect();
+	}
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+	TEST_ASSERT_EQUAL_UINT32((TEST_BUSYTICKS - 1) * TEST_READPULSES, test_pulses());  // Reads only
+
+	TIMER2_COMPA_vect();
+	TEST_ASSERT_EQUAL_UINT8(1, lcd_busy_fallback());
+	test_drain();
+	TEST_ASSERT_EQUAL_UINT32(TEST_BUSYTICKS * TEST_READPULSES + 2, test_pulses());
+}
+
+/**
+ * lcd_init() gives a flag that timed out a new chance, a repaired display is polled again.
+ */
+static void test_busy_rearm(void) {
+	mock_lcdbusy(MOCK_LCDSTUCK);
+	lcd_putc('A');
+	test_drain();
+	TEST_ASSERT_EQUAL_UINT8(1, lcd_busy_fallback());
+
+	mock_lcdbusy(2 * TEST_READPULSES);
+	lcd_init();
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+
+	mock_reset();
+	lcd_putc('A');
+	test_drain();
+	TEST_ASSERT_EQUAL_UINT32(3 * TEST_READPULSES, mock_lcdreads());
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+
+	// Stuck again right after the new start, the queue allows it the whole timeout once more
+	mock_lcdbusy(MOCK_LCDSTUCK);
+	lcd_putc('A');
+	for (uint8_t i = 0; i < TEST_BUSYTICKS - 1; i++) {
+		TIMER2_COMPA_vect();
+	}
+	TEST_ASSERT_EQUAL_UINT8(0, lcd_busy_fallback());
+	test_drain();
+	TEST_ASSERT_EQUAL_UINT8(1, lcd_busy_fallback());
+}
+
+int main(void) {
+	mock_lcd(TEST_MOCKPORT(BOARD_LCD_E), LCD_E_PIN, TEST_MOCKPORT(BOARD_LCD_RW), LCD_RW_PIN,
+		TEST_MOCKPORT(BOARD_LCD_DB7), LCD_DB7_PIN);
+
+	UNITY_BEGIN();
+	RUN_TEST(test_busy_poll);
+	RUN_TEST(test_busy_settle);
+	RUN_TEST(test_busy_timeout);
+	RUN_TEST(test_busy_timeout_queue);
+	RUN_TEST(test_busy_rearm);
+	return UNITY_END();
+}